@@ -10,6 +10,7 @@
 #include "enum/channellayout.hpp"
 #include "misc/log.hpp"
 #include "misc/speedmeasure.hpp"
+#include "misc/tracerecorder.hpp"
 extern "C" {
 #include <audio/filter/af.h>
 }
@@ -257,6 +258,7 @@ auto AudioController::filter(af_instance *af, mp_audio *data) -> int
     auto ac = priv(af); AudioController::Data *d = ac->d;
     if (!data)
         return 0;
+    _TraceScope("AudioController::filter");
 
     d->af->delay = 0.0;
 
@@ -62,6 +62,7 @@ HEADERS += \
 	video/videoformat.hpp \
 	video/hwacc.hpp \
 	video/videofilter.hpp \
+	video/decoderqualitycontroller.hpp \
 	video/deintoption.hpp \
 	video/letterboxitem.hpp \
 	video/ffmpegfilters.hpp \
@@ -80,8 +81,12 @@ HEADERS += \
 	subtitle/subtitlerendereritem.hpp \
 	subtitle/subtitledrawer.hpp \
 	subtitle/subtitlerenderingthread.hpp \
+	subtitle/subtitlerenderpool.hpp \
 	subtitle/submisc.hpp \
 	subtitle/opensubtitlesfinder.hpp \
+	subtitle/subtitleloader.hpp \
+	subtitle/subtitleautoloader.hpp \
+	subtitle/subtitlesearchindex.hpp \
 	quick/busyiconitem.hpp \
 	quick/toplevelitem.hpp \
 	quick/itemwrapper.hpp \
@@ -100,6 +105,8 @@ HEADERS += \
 	opengl/openglvertex.hpp \
 	opengl/opengltexturebase.hpp \
 	opengl/openglframebufferobject.hpp \
+	opengl/opengltexturepool.hpp \
+	opengl/opengltextureuploader.hpp \
 	opengl/opengltexture2d.hpp \
 	opengl/opengltexture1d.hpp \
 	opengl/opengltexturebinder.hpp \
@@ -160,6 +167,9 @@ HEADERS += \
 	misc/xmlrpcclient.hpp \
 	misc/simplelistmodel.hpp \
 	misc/log.hpp \
+	misc/tracerecorder.hpp \
+	misc/startuptimeline.hpp \
+	misc/flatmap.hpp \
 	misc/udf25.hpp \
 	misc/keymodifieractionmap.hpp \
 	misc/enumaction.hpp \
@@ -183,6 +193,7 @@ HEADERS += \
 	player/mpv_helper.hpp \
 	player/playengine_p.hpp \
 	player/historymodel.hpp \
+	player/historywriter.hpp \
 	player/playlistmodel.hpp \
 	player/mainquickview.hpp \
     audio/channellayoutmap.hpp \
@@ -196,6 +207,7 @@ HEADERS += \
     misc/is_convertible.hpp \
     misc/jsonstorage.hpp \
     player/mrlstatesqlfield.hpp \
+    player/mrlstatefields.hpp \
     tmp/algorithm.hpp \
     tmp/arithmetic_type.hpp \
     tmp/static_for.hpp \
@@ -249,6 +261,7 @@ SOURCES += \
 	video/hwacc.cpp \
 	video/videoformat.cpp \
 	video/videofilter.cpp \
+	video/decoderqualitycontroller.cpp \
 	video/deintoption.cpp \
 	video/letterboxitem.cpp \
 	video/ffmpegfilters.cpp \
@@ -267,8 +280,12 @@ SOURCES += \
 	subtitle/subtitlerendereritem.cpp \
 	subtitle/subtitledrawer.cpp \
 	subtitle/subtitlerenderingthread.cpp \
+	subtitle/subtitlerenderpool.cpp \
 	subtitle/submisc.cpp \
 	subtitle/opensubtitlesfinder.cpp \
+	subtitle/subtitleloader.cpp \
+	subtitle/subtitleautoloader.cpp \
+	subtitle/subtitlesearchindex.cpp \
 	quick/geometryitem.cpp \
 	quick/busyiconitem.cpp \
 	quick/toplevelitem.cpp \
@@ -287,6 +304,8 @@ SOURCES += \
 	opengl/openglvertex.cpp \
 	opengl/opengltexturebase.cpp \
 	opengl/openglframebufferobject.cpp \
+	opengl/opengltexturepool.cpp \
+	opengl/opengltextureuploader.cpp \
 	opengl/opengltexture2d.cpp \
 	opengl/opengltexture1d.cpp \
 	opengl/opengltexturebinder.cpp \
@@ -346,6 +365,8 @@ SOURCES += \
 	misc/actiongroup.cpp \
 	misc/xmlrpcclient.cpp \
 	misc/log.cpp \
+	misc/tracerecorder.cpp \
+	misc/startuptimeline.cpp \
 	misc/simplelistmodel.cpp \
 	misc/udf25.cpp \
 	misc/keymodifieractionmap.cpp \
@@ -368,6 +389,7 @@ SOURCES += \
 	player/mediamisc.cpp \
 	player/mrlstate.cpp \
 	player/historymodel.cpp \
+	player/historywriter.cpp \
 	player/mpv_helper.cpp \
 	player/mainquickview.cpp \
     audio/channellayoutmap.cpp \
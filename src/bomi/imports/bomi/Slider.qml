@@ -11,6 +11,7 @@ Item {
     property real range: slider.range
     property alias orientation: slider.orientation
     property alias rate: slider.rate
+    property alias pressed: slider.pressed
     MouseArea {
         anchors.fill: parent
         Qc.Slider {
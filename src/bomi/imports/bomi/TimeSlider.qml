@@ -11,11 +11,12 @@ Slider {
     }
     Connections {
         target: engine
-        onTick: {
+        onTimeChanged: {
             d.ticking = true;
             seeker.value = engine.time
             d.ticking = false;
         }
     }
     onValueChanged: if (!d.ticking) engine.seek(value)
+    onPressedChanged: engine.scrubbing = pressed
 }
@@ -1,22 +1,56 @@
 #include "charsetdetector.hpp"
 #include <chardet.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// chardet starts over on every call, so it is run on a prefix of this size
+// which is doubled until it is sure enough
+static constexpr int BlockSize = 64*1024;
+static constexpr int CacheSize = 256;
 
 struct CharsetDetector::Data {
-    DetectObj *obj;
-    bool detected;
+    Detect *det = nullptr;
+    QByteArray fed; // chardet takes null-terminated string
+    QString encoding;
+    double confidence = 0.0;
+    bool detected = false;
 };
 
+CharsetDetector::CharsetDetector()
+    : d(new Data)
+{
+    d->det = detect_init();
+}
+
 CharsetDetector::CharsetDetector(const QByteArray &data)
-: d(new Data) {
-    d->obj = detect_obj_init();
-    d->detected = (::detect(data.data(), &d->obj) == CHARDET_SUCCESS);
+    : CharsetDetector()
+{
+    feed(data.constData(), data.size());
 }
 
 CharsetDetector::~CharsetDetector() {
-    detect_obj_free(&d->obj);
+    detect_destroy(&d->det);
     delete d;
 }
 
+auto CharsetDetector::feed(const char *data, int size, double confidence) -> bool
+{
+    if (size <= 0)
+        return d->detected && d->confidence > confidence;
+    d->fed.append(data, size);
+    auto obj = detect_obj_init();
+    if (detect_handledata(&d->det, d->fed.constData(), &obj) == CHARDET_SUCCESS) {
+        d->detected = true;
+        d->encoding = _L(obj->encoding);
+        d->confidence = obj->confidence;
+        if (d->encoding.compare("EUC-KR"_a, QCI) == 0)
+            d->encoding = u"CP949"_q;
+    }
+    detect_obj_free(&obj);
+    return d->detected && d->confidence > confidence;
+}
+
 auto CharsetDetector::isDetected() const -> bool
 {
     return d->detected;
@@ -24,33 +58,168 @@ auto CharsetDetector::isDetected() const -> bool
 
 auto CharsetDetector::encoding() const -> QString
 {
-    if (d->detected) {
-        const QString enc(_L(d->obj->encoding));
-        if (enc.compare("EUC-KR"_a, QCI) == 0)
-            return u"CP949"_q;
-        return enc;
-    }
-    return QString();
+    return d->detected ? d->encoding : QString();
 }
 
 auto CharsetDetector::confidence() const -> double
 {
-    return d->detected ? d->obj->confidence : 0.0;
+    return d->detected ? d->confidence : 0.0;
+}
+
+// index of first byte which is non-ASCII or ESC starting ISO-2022 sequences
+static auto skipAscii(const uchar *data, int from, int size) -> int
+{
+    int i = from;
+#ifdef __SSE2__
+    const auto esc = _mm_set1_epi8(0x1b);
+    for (; i + 16 <= size; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, esc))))
+            break;
+    }
+#endif
+    while (i < size && data[i] < 0x80 && data[i] != 0x1b)
+        ++i;
+    return i;
 }
 
+auto CharsetDetector::sniff(const char *data, int size) -> QString
+{
+    auto bytes = reinterpret_cast<const uchar*>(data);
+    if (size >= 3 && bytes[0] == 0xef && bytes[1] == 0xbb && bytes[2] == 0xbf)
+        return u"UTF-8"_q;
+    if (size >= 2 && bytes[0] == 0xff && bytes[1] == 0xfe)
+        return u"UTF-16LE"_q;
+    if (size >= 2 && bytes[0] == 0xfe && bytes[1] == 0xff)
+        return u"UTF-16BE"_q;
+    bool high = false, esc = false;
+    for (int i = skipAscii(bytes, 0, size); i < size; i = skipAscii(bytes, i, size)) {
+        const uchar c = bytes[i];
+        if (c == 0x1b) {
+            esc = true;
+            ++i;
+            continue;
+        }
+        int len = 0; uchar min = 0x80, max = 0xbf;
+        if (0xc2 <= c && c <= 0xdf)
+            len = 2;
+        else if (0xe0 <= c && c <= 0xef) {
+            len = 3;
+            if (c == 0xe0)
+                min = 0xa0;
+            else if (c == 0xed)
+                max = 0x9f; // surrogates
+        } else if (0xf0 <= c && c <= 0xf4) {
+            len = 4;
+            if (c == 0xf0)
+                min = 0x90;
+            else if (c == 0xf4)
+                max = 0x8f;
+        } else
+            return QString();
+        if (i + len > size)
+            break; // cut in the middle of sequence
+        if (bytes[i + 1] < min || bytes[i + 1] > max)
+            return QString();
+        for (int j = 2; j < len; ++j) {
+            if ((bytes[i + j] & 0xc0) != 0x80)
+                return QString();
+        }
+        high = true;
+        i += len;
+    }
+    // 7-bit text with escape sequences may be ISO-2022-*
+    return high || !esc ? u"UTF-8"_q : QString();
+}
+
+// returns true if detection stopped before all data were fed
+static auto feedPrefixes(CharsetDetector &chardet, const char *data, int size,
+                         double confidence) -> bool
+{
+    for (int fed = 0, len = qMin(BlockSize, size); fed < size;
+         fed = len, len = qMin(len * 2, size)) {
+        if (chardet.feed(data + fed, len - fed, confidence))
+            return len < size;
+    }
+    return false;
+}
 
 auto CharsetDetector::detect(const QByteArray &data, double confidence) -> QString
 {
-    CharsetDetector chardet(data);
-    if (chardet.isDetected() && chardet.confidence() > confidence)
-        return chardet.encoding();
-    return QString();
+    const auto enc = sniff(data.constData(), data.size());
+    if (!enc.isEmpty())
+        return enc;
+    CharsetDetector chardet;
+    feedPrefixes(chardet, data.constData(), data.size(), confidence);
+    return chardet.confidence() > confidence ? chardet.encoding() : QString();
 }
 
+struct CharsetCache {
+    struct Entry {
+        qint64 size = 0;
+        QDateTime modified;
+        QString encoding;
+        double confidence = 0.0;
+        bool complete = false; // false if detection stopped early
+    };
+    QMutex mutex;
+    QCache<QString, Entry> entries{CacheSize};
+};
+
 auto CharsetDetector::detect(const QString &fileName, double confidence, int size) -> QString
 {
+    static CharsetCache cache;
+    const QFileInfo info(fileName);
+    const auto path = info.absoluteFilePath();
+    cache.mutex.lock();
+    const auto cached = cache.entries.object(path);
+    if (cached && cached->size == info.size()
+            && cached->modified == info.lastModified()) {
+        const auto enc = cached->encoding;
+        const bool hit = cached->confidence > confidence;
+        const bool complete = cached->complete;
+        cache.mutex.unlock();
+        if (hit)
+            return enc;
+        if (complete)
+            return QString();
+    } else
+        cache.mutex.unlock();
+
     QFile file(fileName);
     if (!file.open(QFile::ReadOnly))
         return QString();
-    return detect(file.read(size), confidence);
+    auto entry = new CharsetCache::Entry;
+    entry->size = info.size();
+    entry->modified = info.lastModified();
+    QByteArray bytes;
+    const char *data = nullptr; int total = 0;
+    uchar *map = nullptr;
+    if (file.size() <= _Max<int>() && (map = file.map(0, file.size()))) {
+        data = reinterpret_cast<const char*>(map);
+        total = file.size();
+    } else {
+        bytes = file.read(size);
+        data = bytes.constData();
+        total = bytes.size();
+    }
+    // ASCII check is cheap enough to run over whole file
+    entry->encoding = sniff(data, total);
+    if (!entry->encoding.isEmpty()) {
+        entry->confidence = 1.0;
+        entry->complete = true;
+    } else {
+        CharsetDetector chardet;
+        const int len = qMin(total, size);
+        entry->complete = !feedPrefixes(chardet, data, len, confidence);
+        entry->encoding = chardet.encoding();
+        entry->confidence = chardet.confidence();
+    }
+    if (map)
+        file.unmap(map);
+    const auto enc = entry->confidence > confidence ? entry->encoding : QString();
+    cache.mutex.lock();
+    cache.entries.insert(path, entry);
+    cache.mutex.unlock();
+    return enc;
 }
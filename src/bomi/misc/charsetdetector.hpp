@@ -3,11 +3,18 @@
 
 class CharsetDetector {
 public:
+    CharsetDetector();
     CharsetDetector(const QByteArray &data);
     ~CharsetDetector();
+    // appends next block and detects over all data fed so far. returns true
+    // when confidence exceeds given one so that rest of data need not be fed
+    auto feed(const char *data, int size, double confidence = 1.0) -> bool;
     auto isDetected() const -> bool;
     auto encoding() const -> QString;
     auto confidence() const -> double;
+    // tells BOM, pure ASCII and valid UTF-8 without chardet; empty if unsure
+    static auto sniff(const char *data, int size) -> QString;
+    // result for same path, size and modification time is cached
     static QString detect(const QString &fileName
             , double confidence = 0.6, int size = 1024*500);
     static auto detect(const QByteArray &data, double confidence = 0.6) -> QString;
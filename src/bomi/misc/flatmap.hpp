@@ -0,0 +1,112 @@
+#ifndef FLATMAP_HPP
+#define FLATMAP_HPP
+
+// Sorted contiguous key-value storage with the subset of QMap interface
+// which is used for captions. Lookup is binary search and iteration walks
+// memory linearly. Insertion in ascending order appends, others shift.
+// Iterators are invalidated by insertion unlike QMap.
+template<class Key, class T>
+class FlatMap {
+    struct Node { Key key; T value; };
+    using Nodes = QVector<Node>;
+    template<class N, class V>
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = V*;
+        using reference = V&;
+        Iterator() { }
+        template<class N2, class V2>
+        Iterator(const Iterator<N2, V2> &rhs): n(rhs.n) { }
+        auto key() const -> const Key& { return n->key; }
+        auto value() const -> V& { return n->value; }
+        auto operator * () const -> V& { return n->value; }
+        auto operator -> () const -> V* { return &n->value; }
+        auto operator ++ () -> Iterator& { ++n; return *this; }
+        auto operator -- () -> Iterator& { --n; return *this; }
+        auto operator ++ (int) -> Iterator { return Iterator(n++); }
+        auto operator -- (int) -> Iterator { return Iterator(n--); }
+        auto operator += (difference_type d) -> Iterator& { n += d; return *this; }
+        auto operator -= (difference_type d) -> Iterator& { n -= d; return *this; }
+        auto operator + (difference_type d) const -> Iterator { return Iterator(n + d); }
+        auto operator - (difference_type d) const -> Iterator { return Iterator(n - d); }
+        auto operator - (const Iterator &rhs) const -> difference_type { return n - rhs.n; }
+        auto operator == (const Iterator &rhs) const -> bool { return n == rhs.n; }
+        auto operator != (const Iterator &rhs) const -> bool { return n != rhs.n; }
+        auto operator < (const Iterator &rhs) const -> bool { return n < rhs.n; }
+    private:
+        Iterator(N *n): n(n) { }
+        N *n = nullptr;
+        template<class N2, class V2> friend class Iterator;
+        friend class FlatMap;
+    };
+public:
+    using iterator = Iterator<Node, T>;
+    using const_iterator = Iterator<const Node, const T>;
+    auto isEmpty() const -> bool { return m_nodes.isEmpty(); }
+    auto size() const -> int { return m_nodes.size(); }
+    auto clear() -> void { m_nodes.clear(); }
+    auto reserve(int size) -> void { m_nodes.reserve(size); }
+    auto begin() -> iterator { return m_nodes.data(); }
+    auto end() -> iterator { return m_nodes.data() + m_nodes.size(); }
+    auto begin() const -> const_iterator { return m_nodes.constData(); }
+    auto end() const -> const_iterator
+        { return m_nodes.constData() + m_nodes.size(); }
+    auto cbegin() const -> const_iterator { return begin(); }
+    auto cend() const -> const_iterator { return end(); }
+    auto lowerBound(const Key &key) -> iterator
+        { const int idx = lower(key) - m_nodes.constData(); return begin() + idx; }
+    auto upperBound(const Key &key) -> iterator
+        { const int idx = upper(key) - m_nodes.constData(); return begin() + idx; }
+    auto lowerBound(const Key &key) const -> const_iterator { return lower(key); }
+    auto upperBound(const Key &key) const -> const_iterator { return upper(key); }
+    auto find(const Key &key) const -> const_iterator
+        { auto it = lowerBound(key); return it != end() && it.key() == key ? it : end(); }
+    auto contains(const Key &key) const -> bool { return find(key) != end(); }
+    auto value(const Key &key, const T &def = T()) const -> T
+        { auto it = find(key); return it != end() ? *it : def; }
+    // replaces existing value as QMap does
+    auto insert(const Key &key, const T &value) -> iterator;
+    auto operator[] (const Key &key) -> T&;
+    auto operator[] (const Key &key) const -> T { return value(key); }
+private:
+    auto lower(const Key &key) const -> const Node*
+    {
+        return std::lower_bound(m_nodes.cbegin(), m_nodes.cend(), key,
+                                [] (const Node &n, const Key &k) { return n.key < k; });
+    }
+    auto upper(const Key &key) const -> const Node*
+    {
+        return std::upper_bound(m_nodes.cbegin(), m_nodes.cend(), key,
+                                [] (const Key &k, const Node &n) { return k < n.key; });
+    }
+    Nodes m_nodes;
+};
+
+template<class Key, class T>
+auto FlatMap<Key, T>::insert(const Key &key, const T &value) -> iterator
+{
+    if (m_nodes.isEmpty() || m_nodes.last().key < key) {
+        m_nodes.push_back({ key, value });
+        return end() - 1;
+    }
+    const int idx = lower(key) - m_nodes.constData();
+    if (idx < m_nodes.size() && m_nodes[idx].key == key)
+        m_nodes[idx].value = value;
+    else
+        m_nodes.insert(idx, { key, value });
+    return begin() + idx;
+}
+
+template<class Key, class T>
+auto FlatMap<Key, T>::operator[] (const Key &key) -> T&
+{
+    auto it = lowerBound(key);
+    if (it == end() || it.key() != key)
+        it = insert(key, T());
+    return *it;
+}
+
+#endif // FLATMAP_HPP
@@ -1,7 +1,256 @@
 #include "misc/log.hpp"
+#include <chrono>
 
 Log::Level Log::m_maxLevel = Log::Info;
 
 const QStringList Log::m_options = QStringList()
         << u"fatal"_q << u"error"_q << u"warn"_q
         << u"info"_q  << u"debug"_q << u"trace"_q;
+
+QList<QByteArray> Log::m_contexts;
+
+// writer drains rings at least this often
+static constexpr int FlushInterval = 20;
+// set when writer has gone during static destruction
+static std::atomic<bool> s_closed{false};
+
+struct LogRecord {
+    qint64 time = 0; // usecs of steady clock
+    quintptr thread = 0;
+    Log::Level level = Log::Info;
+    const char *ctx = nullptr;
+    QByteArray text;
+};
+
+// pushed by owner thread and popped by writer thread only
+struct LogRing {
+    static constexpr quint32 Size = 512; // power of two
+    auto push(LogRecord &&record) -> bool
+    {
+        const auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= Size)
+            return false;
+        records[h & (Size - 1)] = std::move(record);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    auto pop(LogRecord &record) -> bool
+    {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        record = std::move(records[t & (Size - 1)]);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    auto size() const -> quint32
+        { return head.load(std::memory_order_relaxed)
+                 - tail.load(std::memory_order_relaxed); }
+    std::array<LogRecord, Size> records;
+    std::atomic<quint32> head{0}, tail{0};
+    std::atomic<bool> orphan{false}; // owner thread has finished
+};
+
+class LogWriter : public QThread {
+public:
+    LogWriter()
+    {
+        using namespace std::chrono;
+        const auto now = steady_clock::now().time_since_epoch();
+        m_epoch = QDateTime::currentMSecsSinceEpoch() * 1000
+                  - duration_cast<microseconds>(now).count();
+        start(LowPriority);
+    }
+    ~LogWriter()
+    {
+        s_closed = true;
+        m_mutex.lock();
+        m_quit = true;
+        m_wakeup.wakeOne();
+        m_mutex.unlock();
+        wait();
+    }
+    auto ring() -> LogRing*
+    {
+        struct Holder {
+            ~Holder() { if (ring) ring->orphan = true; }
+            LogRing *ring = nullptr;
+        };
+        static thread_local Holder holder;
+        if (!holder.ring) {
+            holder.ring = new LogRing;
+            QMutexLocker locker(&m_mutex);
+            m_rings.push_back(holder.ring);
+        }
+        return holder.ring;
+    }
+    auto push(LogRecord &&record) -> void
+    {
+        auto ring = this->ring();
+        if (!ring->push(std::move(record))) {
+            flush();
+            if (!ring->push(std::move(record)))
+                ++m_dropped;
+        }
+        if (ring->size() == LogRing::Size / 2)
+            m_wakeup.wakeOne();
+    }
+    auto flush() -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto target = ++m_requested;
+        m_wakeup.wakeOne();
+        while (m_flushed < target && isRunning())
+            m_drained.wait(&m_mutex);
+    }
+    auto setFile(const QString &fileName) -> bool
+    {
+        QMutexLocker locker(&m_fileMutex);
+        m_file.close();
+        if (fileName.isEmpty())
+            return true;
+        m_file.setFileName(fileName);
+        return m_file.open(QFile::WriteOnly | QFile::Append);
+    }
+private:
+    auto run() -> void override
+    {
+        QVector<LogRecord> batch;
+        m_mutex.lock();
+        for (;;) {
+            const bool quit = m_quit;
+            const auto requested = m_requested;
+            const auto rings = m_rings;
+            m_mutex.unlock();
+            drain(rings, batch);
+            m_mutex.lock();
+            m_flushed = requested;
+            m_drained.wakeAll();
+            if (quit)
+                break;
+            if (m_requested == requested && !m_quit)
+                m_wakeup.wait(&m_mutex, FlushInterval);
+        }
+        m_mutex.unlock();
+    }
+    auto drain(const QVector<LogRing*> &rings, QVector<LogRecord> &batch) -> void
+    {
+        batch.clear();
+        LogRecord record;
+        QVector<LogRing*> finished;
+        for (auto ring : rings) {
+            const bool orphan = ring->orphan;
+            while (ring->pop(record))
+                batch.push_back(std::move(record));
+            if (orphan)
+                finished.push_back(ring);
+        }
+        if (!finished.isEmpty()) {
+            QMutexLocker locker(&m_mutex);
+            for (auto ring : finished) {
+                m_rings.removeOne(ring);
+                delete ring;
+            }
+        }
+        // rings of threads are merged by time
+        std::stable_sort(batch.begin(), batch.end(),
+                         [] (const LogRecord &lhs, const LogRecord &rhs)
+                         { return lhs.time < rhs.time; });
+        if (const int dropped = m_dropped.exchange(0))
+            qDebug("[Log] %d messages have been dropped", dropped);
+        QMutexLocker locker(&m_fileMutex);
+        for (auto &r : batch) {
+            if (r.ctx)
+                qDebug("[%s] %s", r.ctx, r.text.constData());
+            else
+                qDebug("%s", r.text.constData());
+            if (m_file.isOpen())
+                m_file.write(toJson(r));
+        }
+        if (m_file.isOpen())
+            m_file.flush();
+    }
+    auto toJson(const LogRecord &r) const -> QByteArray
+    {
+        QJsonObject json;
+        json[u"time"_q] = double(m_epoch + r.time) / 1000.0;
+        json[u"thread"_q] = QString::number(r.thread, 16);
+        json[u"level"_q] = Log::options().value(r.level);
+        if (r.ctx)
+            json[u"context"_q] = _L(r.ctx);
+        json[u"message"_q] = QString::fromLocal8Bit(r.text);
+        return QJsonDocument(json).toJson(QJsonDocument::Compact) + '\n';
+    }
+    QMutex m_mutex, m_fileMutex;
+    QWaitCondition m_wakeup, m_drained;
+    QVector<LogRing*> m_rings;
+    quint64 m_requested = 0, m_flushed = 0;
+    bool m_quit = false;
+    std::atomic<int> m_dropped{0};
+    qint64 m_epoch = 0; // usecs since Unix epoch at zero of steady clock
+    QFile m_file;
+};
+
+static auto writer() -> LogWriter&
+{
+    static LogWriter writer;
+    return writer;
+}
+
+auto Log::print(const char *ctx, Level lv, const QByteArray &log) -> void
+{
+    if (s_closed) {
+        qDebug("[%s] %s", ctx ? ctx : "Log", log.constData());
+        if (lv == Fatal)
+            exit(1);
+        return;
+    }
+    using namespace std::chrono;
+    LogRecord record;
+    const auto now = steady_clock::now().time_since_epoch();
+    record.time = duration_cast<microseconds>(now).count();
+    record.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    record.level = lv;
+    record.ctx = ctx;
+    record.text = log;
+    writer().push(std::move(record));
+    if (lv == Fatal) {
+        writer().flush();
+        exit(1);
+    }
+}
+
+auto Log::flush() -> void
+{
+    if (!s_closed)
+        writer().flush();
+}
+
+auto Log::setFile(const QString &fileName) -> bool
+{
+    return writer().setFile(fileName);
+}
+
+auto Log::context(const QByteArray &name) -> const char*
+{
+    static QMutex mutex;
+    static QSet<QByteArray> names;
+    QMutexLocker locker(&mutex);
+    return names.insert(name)->constData();
+}
+
+auto Log::setContexts(const QStringList &contexts) -> void
+{
+    m_contexts.clear();
+    for (auto &ctx : contexts)
+        m_contexts.push_back(ctx.trimmed().toLatin1());
+}
+
+auto Log::hasContext(const char *ctx) -> bool
+{
+    for (auto &one : m_contexts) {
+        if (!qstrcmp(one.constData(), ctx))
+            return true;
+    }
+    return false;
+}
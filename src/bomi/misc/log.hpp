@@ -39,17 +39,18 @@ public:
     enum Level { Fatal, Error, Warn, Info, Debug, Trace };
     static auto maximumLevel() -> Level { return m_maxLevel; }
     static auto  setMaximumLevel(Level level) -> void { m_maxLevel = level; }
+    // text is formatted only when level and context are enabled
     template<class F>
     static auto write(const char *ctx, Level level, const F &getLogText) -> void
     {
-        if (level <= m_maxLevel)
+        if (level <= m_maxLevel && isEnabled(ctx))
             print(ctx, level, getLogText());
     }
     template<class... Args>
     static auto write(const char *ctx, Level level, const QByteArray &format,
                       const Args &... args) -> void
     {
-        if (level <= m_maxLevel)
+        if (level <= m_maxLevel && isEnabled(ctx))
             print(ctx, level, Helper(format, args...).log());
     }
     template<class... Args>
@@ -68,19 +69,22 @@ public:
         const int index = m_options.indexOf(option);
         setMaximumLevel(index < 0 ? Info : (Level)index);
     }
+    // only given contexts are logged; all if empty
+    static auto setContexts(const QStringList &contexts) -> void;
+    static auto isEnabled(const char *ctx) -> bool
+        { return m_contexts.isEmpty() || !ctx || hasContext(ctx); }
+    // context which lives until exit for a name built at runtime
+    static auto context(const QByteArray &name) -> const char*;
+    // writes logs in JSON lines to file in addition to stderr
+    static auto setFile(const QString &fileName) -> bool;
+    // blocks until all logs written so far are printed
+    static auto flush() -> void;
 private:
-    static auto print(const char *ctx, Level lv, const QByteArray &log) -> void
-    {
-        qDebug("[%s] %s", ctx, log.constData());
-        if (lv == Fatal)
-            exit(1);
-    }
+    // logs are queued in per-thread ring and printed in writer thread
+    static auto print(const char *ctx, Level lv, const QByteArray &log) -> void;
     static auto print(Level level, const QByteArray &log) -> void
-    {
-        qDebug("%s", log.constData());
-        if (level == Fatal)
-            exit(1);
-    }
+        { print(nullptr, level, log); }
+    static auto hasContext(const char *ctx) -> bool;
     struct Helper {
         template<class... Args>
         inline Helper(const QByteArray &format, const Args &... args)
@@ -114,6 +118,7 @@ private:
     };
     static Level m_maxLevel;
     static const QStringList m_options;
+    static QList<QByteArray> m_contexts;
 };
 
 #define DECLARE_LOG_CONTEXT(ctx) \
@@ -0,0 +1,61 @@
+#include "startuptimeline.hpp"
+#include "misc/log.hpp"
+#include <chrono>
+
+DECLARE_LOG_CONTEXT(Startup)
+
+using Clock = std::chrono::steady_clock;
+
+// first frame is expected within this
+static constexpr double TargetMs = 300.0;
+// statics are initialized before main() begins
+static const Clock::time_point s_launched = Clock::now();
+static QMutex s_mutex;
+
+struct StartupPhase { const char *name; double ms; };
+static QVector<StartupPhase> s_phases;
+
+std::atomic<bool> StartupTimeline::m_finished{false};
+
+static auto _ElapsedMs() -> double
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - s_launched).count();
+}
+
+auto StartupTimeline::mark(const char *phase) -> void
+{
+    if (isFinished())
+        return;
+    const auto ms = _ElapsedMs();
+    QMutexLocker locker(&s_mutex);
+    s_phases.push_back({ phase, ms });
+}
+
+auto StartupTimeline::finish(const char *phase) -> void
+{
+    if (isFinished())
+        return;
+    const auto ms = _ElapsedMs();
+    QVector<StartupPhase> phases;
+    {
+        QMutexLocker locker(&s_mutex);
+        if (m_finished.exchange(true))
+            return;
+        s_phases.push_back({ phase, ms });
+        phases.swap(s_phases);
+    }
+    // phases of other threads may have been marked out of order
+    std::stable_sort(phases.begin(), phases.end(),
+                     [] (const StartupPhase &lhs, const StartupPhase &rhs)
+                     { return lhs.ms < rhs.ms; });
+    auto number = [] (double ms) { return QString::number(ms, 'f', 1); };
+    double prev = 0.0;
+    for (auto &p : phases) {
+        _Debug("%%ms (+%%ms) %%", number(p.ms), number(p.ms - prev), p.name);
+        prev = p.ms;
+    }
+    if (ms > TargetMs)
+        _Debug("'%%' took %%ms over %%ms.", phase, number(ms - TargetMs),
+               number(TargetMs));
+}
@@ -0,0 +1,18 @@
+#ifndef STARTUPTIMELINE_HPP
+#define STARTUPTIMELINE_HPP
+
+// time of each startup phase since launch. phases are printed at once in
+// Startup context with debug level when finished.
+class StartupTimeline {
+public:
+    // phase should be string literal. can be called from any thread.
+    static auto mark(const char *phase) -> void;
+    // marks the last phase and prints timeline only once
+    static auto finish(const char *phase) -> void;
+    static auto isFinished() -> bool
+        { return m_finished.load(std::memory_order_relaxed); }
+private:
+    static std::atomic<bool> m_finished;
+};
+
+#endif // STARTUPTIMELINE_HPP
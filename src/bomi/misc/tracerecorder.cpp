@@ -0,0 +1,221 @@
+#include "tracerecorder.hpp"
+#include "misc/log.hpp"
+#include <chrono>
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#endif
+
+extern "C" {
+extern void mp_set_trace_hook(void (*hook)(const char *name, char phase));
+}
+
+DECLARE_LOG_CONTEXT(Trace)
+
+std::atomic<bool> TraceRecorder::m_recording{false};
+
+struct TraceEvent {
+    qint64 time; // usecs of steady clock
+    const char *name;
+    char phase;
+};
+
+// appended by owner thread only. events are read while recording is
+// stopped but owner may still be finishing the last one.
+struct TraceBuffer {
+    static constexpr int ChunkSize = 4096;
+    static constexpr int MaxChunks = 256;
+    struct Chunk {
+        std::array<TraceEvent, ChunkSize> events;
+        std::atomic<int> size{0};
+        std::atomic<Chunk*> next{nullptr};
+    };
+    ~TraceBuffer()
+    {
+        for (auto c = first.next.load(); c; ) {
+            auto next = c->next.load();
+            delete c;
+            c = next;
+        }
+    }
+    auto push(const TraceEvent &event) -> void
+    {
+        int size = last->size.load(std::memory_order_relaxed);
+        if (size == ChunkSize) {
+            auto next = last->next.load(std::memory_order_relaxed);
+            if (!next) {
+                if (chunks >= MaxChunks)
+                    return;
+                next = new Chunk;
+                ++chunks;
+                last->next.store(next, std::memory_order_release);
+            }
+            last = next;
+            size = 0;
+        }
+        last->events[size] = event;
+        last->size.store(size + 1, std::memory_order_release);
+    }
+    // chunks are reused for next recording
+    auto reset(int generation) -> void
+    {
+        for (auto c = &first; c; c = c->next.load(std::memory_order_relaxed))
+            c->size.store(0, std::memory_order_relaxed);
+        last = &first;
+        this->generation = generation;
+    }
+    Chunk first;
+    Chunk *last = &first;
+    int chunks = 1, generation = -1, id = 0;
+    QByteArray name;
+    std::atomic<bool> orphan{false}; // owner thread has finished
+};
+
+struct TraceRegistry {
+    QMutex mutex;
+    QVector<TraceBuffer*> buffers;
+    std::atomic<int> generation{0};
+    qint64 origin = 0;
+    int ids = 0;
+    auto dropOrphans() -> void
+    {
+        for (int i = 0; i < buffers.size(); ) {
+            if (buffers[i]->orphan) {
+                delete buffers[i];
+                buffers.remove(i);
+            } else
+                ++i;
+        }
+    }
+};
+
+static auto registry() -> TraceRegistry&
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+static auto now() -> qint64
+{
+    using namespace std::chrono;
+    const auto time = steady_clock::now().time_since_epoch();
+    return duration_cast<microseconds>(time).count();
+}
+
+static auto threadName(int id) -> QByteArray
+{
+#ifdef Q_OS_LINUX
+    char name[32] = {0};
+    if (!pthread_getname_np(pthread_self(), name, sizeof(name)) && name[0])
+        return QByteArray(name);
+#endif
+    return "thread-" + QByteArray::number(id);
+}
+
+// thread names come from outside and may contain anything
+static auto escaped(const QByteArray &str) -> QByteArray
+{
+    QByteArray ret;
+    ret.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\')
+            ret += '\\';
+        if (static_cast<uchar>(c) < 0x20)
+            ret += "\\u00" + QByteArray::number(c, 16).rightJustified(2, '0');
+        else
+            ret += c;
+    }
+    return ret;
+}
+
+static auto mpvTrace(const char *name, char phase) -> void
+{
+    if (phase == 'B')
+        TraceRecorder::begin(name);
+    else
+        TraceRecorder::end(name);
+}
+
+auto TraceRecorder::record(const char *name, char phase) -> void
+{
+    struct Holder {
+        ~Holder() { if (buffer) buffer->orphan = true; }
+        TraceBuffer *buffer = nullptr;
+    };
+    static thread_local Holder holder;
+    auto &reg = registry();
+    if (!holder.buffer) {
+        auto buffer = new TraceBuffer;
+        QMutexLocker locker(&reg.mutex);
+        buffer->id = ++reg.ids;
+        buffer->name = threadName(buffer->id);
+        reg.buffers.push_back(buffer);
+        holder.buffer = buffer;
+    }
+    const int generation = reg.generation.load(std::memory_order_acquire);
+    if (holder.buffer->generation != generation)
+        holder.buffer->reset(generation);
+    holder.buffer->push({ now(), name, phase });
+}
+
+auto TraceRecorder::start() -> void
+{
+    auto &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    if (m_recording)
+        return;
+    reg.dropOrphans();
+    reg.origin = now();
+    ++reg.generation;
+    mp_set_trace_hook(mpvTrace);
+    m_recording = true;
+    _Info("Start recording trace events.");
+}
+
+auto TraceRecorder::stop(const QString &fileName) -> bool
+{
+    auto &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    if (!m_recording)
+        return false;
+    m_recording = false;
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        _Error("Cannot write trace events to %%", fileName);
+        return false;
+    }
+    const auto generation = reg.generation.load();
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"_b;
+    auto tail = [&] (int tid) {
+        if (json.size() > 1024*1024) {
+            file.write(json);
+            json.clear();
+        }
+        json += "\"pid\":1,\"tid\":" + QByteArray::number(tid) + "},\n";
+    };
+    int count = 0;
+    for (auto buffer : reg.buffers) {
+        if (buffer->generation != generation)
+            continue;
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"args\":{\"name\":\""
+                + escaped(buffer->name) + "\"},";
+        tail(buffer->id);
+        for (auto c = &buffer->first; c; c = c->next.load(std::memory_order_acquire)) {
+            const int size = c->size.load(std::memory_order_acquire);
+            for (int i = 0; i < size; ++i) {
+                const auto &e = c->events[i];
+                json += "{\"name\":\"" + QByteArray(e.name) + "\",\"ph\":\""
+                        + e.phase + "\",\"ts\":"
+                        + QByteArray::number(e.time - reg.origin) + ',';
+                tail(buffer->id);
+            }
+            count += size;
+        }
+    }
+    if (json.endsWith(",\n"))
+        json.chop(2);
+    json += "\n]}\n";
+    file.write(json);
+    reg.dropOrphans();
+    _Info("%% trace events have been written to %%", count, fileName);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef TRACERECORDER_HPP
+#define TRACERECORDER_HPP
+
+// records begin and end of scopes in per-thread buffers with steady clock
+// and writes them in Chrome trace event format. mpv threads are recorded
+// through mp_trace_hook. nothing is recorded until start() is called.
+class TraceRecorder {
+public:
+    class Scope {
+    public:
+        Scope(const char *name): m_name(name) { begin(m_name); }
+        ~Scope() { end(m_name); }
+    private:
+        const char *m_name;
+    };
+    static auto isRecording() -> bool
+        { return m_recording.load(std::memory_order_relaxed); }
+    static auto start() -> void;
+    // stops recording and writes events to fileName
+    static auto stop(const QString &fileName) -> bool;
+    // name should be string literal
+    static auto begin(const char *name) -> void
+        { if (isRecording()) record(name, 'B'); }
+    static auto end(const char *name) -> void
+        { if (isRecording()) record(name, 'E'); }
+private:
+    static auto record(const char *name, char phase) -> void;
+    static std::atomic<bool> m_recording;
+};
+
+#define _TraceScope(name) TraceRecorder::Scope traceScope(name)
+
+#endif // TRACERECORDER_HPP
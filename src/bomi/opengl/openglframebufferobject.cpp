@@ -21,6 +21,7 @@ auto makeTexture(const QSize &size, OGL::TextureFormat internal) -> OpenGLTextur
 OpenGLFramebufferObject::OpenGLFramebufferObject(const QSize &size,
                                                  OGL::Target target)
     : m_size(size)
+    , m_viewport(size)
     , m_target(target)
 {
     func()->glGenFramebuffers(1, &m_id);
@@ -63,6 +64,22 @@ auto OpenGLFramebufferObject::attach(const OpenGLTexture2D &texture) -> bool
     return m_complete = checkStatus();
 }
 
+auto OpenGLFramebufferObject::setViewport(const QSize &size) -> void
+{
+    m_viewport = size.boundedTo(m_size);
+    m_texture.m_correction = m_size.isEmpty() ? QPointF(1.0, 1.0)
+        : QPointF(m_viewport.width()/(double)m_size.width(),
+                  m_viewport.height()/(double)m_size.height());
+}
+
+auto OpenGLFramebufferObject::toImage() const -> QImage
+{
+    auto image = m_texture.toImage();
+    if (m_viewport != m_size)
+        image = image.copy(QRect({0, 0}, m_viewport));
+    return image;
+}
+
 auto OpenGLFramebufferObject::checkStatus() const -> bool
 {
     const auto status = func()->glCheckFramebufferStatus(GL_FRAMEBUFFER);
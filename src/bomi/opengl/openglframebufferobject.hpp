@@ -21,6 +21,10 @@ public:
     auto size() const -> QSize { return m_size; }
     auto width() const -> int { return m_size.width(); }
     auto height() const -> int { return m_size.height(); }
+    // region from origin which is actually in use, whole size by default
+    auto viewport() const -> QSize { return m_viewport; }
+    auto setViewport(const QSize &size) -> void;
+    auto toImage() const -> QImage;
     auto isValid() const -> bool { return m_complete; }
     auto id() const -> GLuint { return m_id; }
     auto attach(const OpenGLTexture2D &texture) -> bool;
@@ -32,7 +36,7 @@ private:
     GLuint m_id = GL_NONE;
     bool m_complete = false, m_autodelete = false;
     OpenGLTexture2D m_texture;
-    QSize m_size;
+    QSize m_size, m_viewport;
     OGL::Target m_target = OGL::Target2D;
 };
 
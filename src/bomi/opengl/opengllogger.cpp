@@ -8,7 +8,7 @@
 
 struct OpenGLLogger::Data {
     QOpenGLDebugLogger *logger = nullptr;
-    QByteArray category;
+    const char *category = nullptr;
     template<class... Args>
     auto error(const QByteArray &format, const Args&... args) -> void
     {
@@ -26,7 +26,7 @@ struct OpenGLLogger::Data {
 OpenGLLogger::OpenGLLogger(const QByteArray &category, QObject *parent)
     : QObject(parent), d(new Data)
 {
-    d->category = "OpenGL/" + category;
+    d->category = Log::context("OpenGL/" + category);
 }
 
 OpenGLLogger::~OpenGLLogger()
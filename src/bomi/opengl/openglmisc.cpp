@@ -79,6 +79,8 @@ auto check() -> void
     checkExtension("GLX_EXT_swap_control"_b, ExtSwapControl);
     checkExtension("GLX_SGI_swap_control"_b, SgiSwapControl);
     checkExtension("GLX_MESA_swap_control"_b, MesaSwapControl);
+    checkExtension("GL_ARB_pixel_buffer_object"_b, PixelBufferObject, 2, 1);
+    checkExtension("GL_ARB_sync"_b, Sync, 3, 2);
 
     if (QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()) {
         extensions.push_back(u"GL_ARB_framebuffer_object"_q);
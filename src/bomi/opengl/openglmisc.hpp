@@ -157,7 +157,9 @@ enum Extension {
     MesaYCbCrTexture  = 1 << 6,
     ExtSwapControl    = 1 << 7,
     SgiSwapControl    = 1 << 8,
-    MesaSwapControl   = 1 << 9
+    MesaSwapControl   = 1 << 9,
+    PixelBufferObject = 1 << 10,
+    Sync              = 1 << 11
 };
 
 auto initialize(QOpenGLContext *ctx, bool debug) -> void;
@@ -0,0 +1,232 @@
+#include "opengltexturepool.hpp"
+#include "openglframebufferobject.hpp"
+#include "opengltexturebinder.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+static constexpr qint64 DefaultBudget = 64*1024*1024;
+
+static auto fboInfo() -> OpenGLTextureTransferInfo
+{
+    return { OGL::RGBA8_UNorm, OGL::BGRA, OGL::UInt8 };
+}
+
+// approximation assuming 4 bytes per texel
+static auto bytes(const QSize &size) -> qint64
+{
+    return qint64(size.width()) * size.height() * 4;
+}
+
+// round up to multiple of step which is between 1/16 and 1/8 of length
+// so that waste is below 12.5% while close sizes share a bucket
+static auto roundUp(int length) -> int
+{
+    if (length <= 0)
+        return 0;
+    int step = 64;
+    while (step * 16 <= length)
+        step *= 2;
+    return (length + step - 1) / step * step;
+}
+
+static auto correction(const QSize &size, const QSize &bucket) -> QPointF
+{
+    return { size.width()/(double)bucket.width(),
+             size.height()/(double)bucket.height() };
+}
+
+struct OpenGLTexturePool::Data {
+    struct Item {
+        OpenGLTexture2D texture;
+        OpenGLFramebufferObject *fbo = nullptr;
+    };
+    QList<Item> idle; // least recently released first
+    qint64 bytes = 0, budget = DefaultBudget;
+};
+
+static QMutex poolMutex;
+static QHash<QOpenGLContext*, OpenGLTexturePool*> pools;
+
+auto OpenGLTexturePool::current() -> OpenGLTexturePool*
+{
+    auto ctx = QOpenGLContext::currentContext();
+    Q_ASSERT(ctx);
+    QMutexLocker locker(&poolMutex);
+    auto &pool = pools[ctx];
+    if (!pool) {
+        pool = new OpenGLTexturePool;
+        // signal is emitted with context current
+        QObject::connect(ctx, &QOpenGLContext::aboutToBeDestroyed, [ctx] () {
+            poolMutex.lock();
+            auto pool = pools.take(ctx);
+            poolMutex.unlock();
+            delete pool;
+        });
+    }
+    return pool;
+}
+
+auto OpenGLTexturePool::bucket(const QSize &size) -> QSize
+{
+    return { roundUp(size.width()), roundUp(size.height()) };
+}
+
+OpenGLTexturePool::OpenGLTexturePool()
+    : d(new Data) { }
+
+OpenGLTexturePool::~OpenGLTexturePool()
+{
+    evict(0);
+    delete d;
+}
+
+auto OpenGLTexturePool::setBudget(qint64 bytes) -> void
+{
+    d->budget = bytes;
+    evict(d->budget);
+}
+
+auto OpenGLTexturePool::budget() const -> qint64
+{
+    return d->budget;
+}
+
+auto OpenGLTexturePool::idleBytes() const -> qint64
+{
+    return d->bytes;
+}
+
+auto OpenGLTexturePool::evict(qint64 budget) -> void
+{
+    while (d->bytes > budget && !d->idle.isEmpty()) {
+        auto item = d->idle.takeFirst();
+        d->bytes -= bytes(item.texture.size());
+        delete item.fbo;
+        item.texture.destroy();
+    }
+}
+
+auto OpenGLTexturePool::take(const QSize &bucket,
+                             const OpenGLTextureTransferInfo &info,
+                             bool fbo) -> int
+{
+    int found = -1;
+    for (int i = d->idle.size() - 1; i >= 0; --i) {
+        const auto &item = d->idle[i];
+        if (item.texture.size() != bucket || item.texture.info() != info)
+            continue;
+        found = i;
+        if ((item.fbo != nullptr) == fbo) // exact kind of storage preferred
+            break;
+    }
+    return found;
+}
+
+auto OpenGLTexturePool::acquire(const QSize &size,
+                                const OpenGLTextureTransferInfo &info)
+    -> OpenGLTexture2D
+{
+    OpenGLTexture2D texture;
+    if (size.isEmpty())
+        return texture;
+    const auto b = bucket(size);
+    const int idx = take(b, info, false);
+    if (idx < 0) {
+        texture.create();
+        OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+        texture.initialize(b, info);
+    } else {
+        auto item = d->idle.takeAt(idx);
+        d->bytes -= bytes(b);
+        delete item.fbo;
+        texture = item.texture;
+    }
+    texture.correction() = correction(size, b);
+    return texture;
+}
+
+auto OpenGLTexturePool::renew(OpenGLTexture2D &texture, const QSize &size,
+                              const OpenGLTextureTransferInfo &info) -> bool
+{
+    if (!texture.isEmpty() && texture.size() == bucket(size)
+            && texture.info() == info) {
+        texture.correction() = correction(size, texture.size());
+        return false;
+    }
+    auto renewed = acquire(size, info);
+    release(texture);
+    texture = renewed;
+    return true;
+}
+
+auto OpenGLTexturePool::release(const OpenGLTexture2D &texture) -> void
+{
+    if (!texture.isValid())
+        return;
+    if (texture.isEmpty() || texture.target() != OGL::Target2D
+            || texture.size() != bucket(texture.size())) {
+        auto tmp = texture;
+        tmp.destroy();
+        return;
+    }
+    Data::Item item;
+    item.texture = texture;
+    d->idle.push_back(item);
+    d->bytes += bytes(texture.size());
+    evict(d->budget);
+}
+
+auto OpenGLTexturePool::acquireFramebufferObject(const QSize &size)
+    -> OpenGLFramebufferObject*
+{
+    if (size.isEmpty())
+        return nullptr;
+    const auto b = bucket(size);
+    const int idx = take(b, fboInfo(), true);
+    OpenGLFramebufferObject *fbo = nullptr;
+    if (idx < 0) {
+        OpenGLTexture2D texture;
+        texture.create();
+        OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+        texture.initialize(b, fboInfo());
+        fbo = new OpenGLFramebufferObject(texture);
+    } else {
+        auto item = d->idle.takeAt(idx);
+        d->bytes -= bytes(b);
+        fbo = item.fbo ? item.fbo : new OpenGLFramebufferObject(item.texture);
+    }
+    fbo->setViewport(size);
+    return fbo;
+}
+
+auto OpenGLTexturePool::renew(OpenGLFramebufferObject *fbo,
+                              const QSize &size) -> OpenGLFramebufferObject*
+{
+    if (fbo && fbo->size() == bucket(size)) {
+        fbo->setViewport(size);
+        return fbo;
+    }
+    auto renewed = acquireFramebufferObject(size);
+    release(fbo);
+    return renewed;
+}
+
+auto OpenGLTexturePool::release(OpenGLFramebufferObject *fbo) -> void
+{
+    if (!fbo)
+        return;
+    const auto texture = fbo->texture();
+    if (!fbo->isValid() || texture.size() != bucket(texture.size())) {
+        delete fbo;
+        auto tmp = texture;
+        tmp.destroy();
+        return;
+    }
+    Data::Item item;
+    item.texture = texture;
+    item.fbo = fbo;
+    d->idle.push_back(item);
+    d->bytes += bytes(texture.size());
+    evict(d->budget);
+}
@@ -0,0 +1,42 @@
+#ifndef OPENGLTEXTUREPOOL_HPP
+#define OPENGLTEXTUREPOOL_HPP
+
+#include "opengltexture2d.hpp"
+
+class OpenGLFramebufferObject;
+
+// Per-context pool of 2D textures and framebuffer objects.
+// Sizes are rounded up to coarse buckets so that resizing a window or
+// a subtitle reuses storage instead of reallocating it on every change.
+// The requested region is exposed by correction() of texture and
+// viewport() of framebuffer object. Idle storage is kept within budget.
+class OpenGLTexturePool {
+public:
+    ~OpenGLTexturePool();
+    // pool for current context; never cache this across contexts
+    static auto current() -> OpenGLTexturePool*;
+    static auto bucket(const QSize &size) -> QSize;
+    auto acquire(const QSize &size, const OpenGLTextureTransferInfo &info)
+        -> OpenGLTexture2D;
+    // returns true if texture has been replaced, i.e. content is undefined
+    auto renew(OpenGLTexture2D &texture, const QSize &size,
+               const OpenGLTextureTransferInfo &info) -> bool;
+    auto release(const OpenGLTexture2D &texture) -> void;
+    // framebuffer object acquired here should be released here, not deleted
+    auto acquireFramebufferObject(const QSize &size) -> OpenGLFramebufferObject*;
+    auto renew(OpenGLFramebufferObject *fbo,
+               const QSize &size) -> OpenGLFramebufferObject*;
+    auto release(OpenGLFramebufferObject *fbo) -> void;
+    auto setBudget(qint64 bytes) -> void;
+    auto budget() const -> qint64;
+    auto idleBytes() const -> qint64;
+private:
+    OpenGLTexturePool();
+    auto take(const QSize &bucket, const OpenGLTextureTransferInfo &info,
+              bool fbo) -> int;
+    auto evict(qint64 budget) -> void;
+    struct Data;
+    Data *d;
+};
+
+#endif // OPENGLTEXTUREPOOL_HPP
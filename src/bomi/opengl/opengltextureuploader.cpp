@@ -0,0 +1,174 @@
+#include "opengltextureuploader.hpp"
+#include "opengltexturebinder.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+typedef GLsync (QOPENGLF_APIENTRYP FenceSync)(GLenum, GLbitfield);
+typedef GLenum (QOPENGLF_APIENTRYP ClientWaitSync)(GLsync, GLbitfield, GLuint64);
+typedef void (QOPENGLF_APIENTRYP DeleteSync)(GLsync);
+
+struct OpenGLTextureUploader::Slot {
+    QOpenGLBuffer buffer{QOpenGLBuffer::PixelUnpackBuffer};
+    GLsync fence = nullptr;
+    int size = 0;
+};
+
+static FenceSync fenceSync = nullptr;
+static ClientWaitSync clientWaitSync = nullptr;
+static DeleteSync deleteSync = nullptr;
+
+auto OpenGLTextureUploader::create() -> void
+{
+    Q_ASSERT(!m_created);
+    m_created = true;
+    m_pbo = OGL::hasExtension(OGL::PixelBufferObject);
+    if (!m_pbo)
+        return;
+    if (OGL::hasExtension(OGL::Sync) && !fenceSync) {
+        auto gl = QOpenGLContext::currentContext();
+        fenceSync = (FenceSync)gl->getProcAddress("glFenceSync");
+        clientWaitSync = (ClientWaitSync)gl->getProcAddress("glClientWaitSync");
+        deleteSync = (DeleteSync)gl->getProcAddress("glDeleteSync");
+        if (!fenceSync || !clientWaitSync || !deleteSync)
+            fenceSync = nullptr;
+    }
+    m_slots = new Slot[Slots];
+    for (int i = 0; i < Slots; ++i) {
+        if (!m_slots[i].buffer.create()) {
+            _Error("Cannot create pixel buffer object. Fallback to direct upload.");
+            m_pbo = false;
+            break;
+        }
+        m_slots[i].buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
+}
+
+auto OpenGLTextureUploader::destroy() -> void
+{
+    if (!m_created)
+        return;
+    if (m_slots) {
+        for (int i = 0; i < Slots; ++i) {
+            if (m_slots[i].fence)
+                deleteSync(m_slots[i].fence);
+            m_slots[i].buffer.destroy();
+        }
+        delete [] m_slots;
+        m_slots = nullptr;
+    }
+    m_jobs.clear();
+    m_created = m_pbo = false;
+}
+
+auto OpenGLTextureUploader::add(const OpenGLTexture2D &texture,
+                                const QRect &rect, const uchar *data,
+                                int stride) -> void
+{
+    if (rect.isEmpty())
+        return;
+    Job job;
+    job.texture = texture;
+    job.rect = rect;
+    job.data = data;
+    job.stride = stride;
+    m_jobs.push_back(job);
+}
+
+auto OpenGLTextureUploader::fill(const OpenGLTexture2D &texture,
+                                 const QRect &rect, quint32 value) -> void
+{
+    if (rect.isEmpty())
+        return;
+    Job job;
+    job.texture = texture;
+    job.rect = rect;
+    job.value = value;
+    m_jobs.push_back(job);
+}
+
+auto OpenGLTextureUploader::copy(uchar *dst, const Job &job) const -> void
+{
+    const int w = job.rect.width(), h = job.rect.height();
+    if (!job.data) {
+        std::fill_n(reinterpret_cast<quint32*>(dst), w * h, job.value);
+        return;
+    }
+    const int len = w * 4;
+    if (job.stride == len) {
+        memcpy(dst, job.data, len * h);
+        return;
+    }
+    auto src = job.data;
+    for (int y = 0; y < h; ++y, dst += len, src += job.stride)
+        memcpy(dst, src, len);
+}
+
+auto OpenGLTextureUploader::uploadDirectly() -> void
+{
+    OpenGLTextureBinder<OGL::Target2D> binder;
+    for (auto &job : m_jobs) {
+        binder.bind(&job.texture);
+        const auto len = job.rect.width() * job.rect.height();
+        if (job.data && job.stride == job.rect.width() * 4) {
+            job.texture.upload(job.rect, job.data);
+        } else {
+            _Expand(m_temp, len);
+            copy(reinterpret_cast<uchar*>(m_temp.data()), job);
+            job.texture.upload(job.rect, m_temp.data());
+        }
+    }
+    m_jobs.clear();
+}
+
+auto OpenGLTextureUploader::commit() -> void
+{
+    Q_ASSERT(m_created);
+    if (m_jobs.isEmpty())
+        return;
+    if (!m_pbo)
+        return uploadDirectly();
+    int total = 0;
+    for (auto &job : m_jobs)
+        total += job.rect.width() * job.rect.height() * 4;
+
+    auto &slot = m_slots[m_next];
+    m_next = (m_next + 1) % Slots;
+    // mapping a buffer which GPU still reads from stalls; orphan it instead
+    bool orphan = slot.size < total || !fenceSync;
+    if (slot.fence) {
+        if (clientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            orphan = true;
+        deleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    slot.buffer.bind();
+    if (orphan) {
+        slot.size = qMax(slot.size, total);
+        slot.buffer.allocate(slot.size);
+    }
+    auto dst = static_cast<uchar*>(slot.buffer.map(QOpenGLBuffer::WriteOnly));
+    if (!dst) {
+        slot.buffer.release();
+        _Error("Cannot map pixel buffer object.");
+        return uploadDirectly();
+    }
+    quintptr offset = 0;
+    QVector<quintptr> offsets; offsets.reserve(m_jobs.size());
+    for (auto &job : m_jobs) {
+        offsets.push_back(offset);
+        copy(dst + offset, job);
+        offset += job.rect.width() * job.rect.height() * 4;
+    }
+    slot.buffer.unmap();
+    OpenGLTextureBinder<OGL::Target2D> binder;
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        auto &job = m_jobs[i];
+        binder.bind(&job.texture);
+        job.texture.upload(job.rect, reinterpret_cast<const void*>(offsets[i]));
+    }
+    if (fenceSync)
+        slot.fence = fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.buffer.release();
+    m_jobs.clear();
+}
@@ -0,0 +1,44 @@
+#ifndef OPENGLTEXTUREUPLOADER_HPP
+#define OPENGLTEXTUREUPLOADER_HPP
+
+#include "opengltexture2d.hpp"
+
+// Batches sub-image uploads of 4-byte texels and streams them through
+// a small ring of pixel buffer objects so that texture transfer does not
+// stall the render thread. Each buffer is fenced and rewritten only when
+// GPU has consumed it, otherwise it is orphaned. Falls back to plain
+// glTexSubImage2D when PBO is not available.
+class OpenGLTextureUploader {
+public:
+    OpenGLTextureUploader() = default;
+    ~OpenGLTextureUploader() { Q_ASSERT(!m_created); }
+    auto create() -> void;
+    auto destroy() -> void;
+    // data should be alive until commit()
+    auto add(const OpenGLTexture2D &texture, const QRect &rect,
+             const uchar *data, int stride) -> void;
+    auto fill(const OpenGLTexture2D &texture, const QRect &rect,
+              quint32 value) -> void;
+    auto commit() -> void;
+    auto isEmpty() const -> bool { return m_jobs.isEmpty(); }
+    auto isStreaming() const -> bool { return m_pbo; }
+private:
+    struct Job {
+        OpenGLTexture2D texture;
+        QRect rect;
+        const uchar *data = nullptr;
+        int stride = 0;
+        quint32 value = 0;
+    };
+    struct Slot;
+    auto uploadDirectly() -> void;
+    auto copy(uchar *dst, const Job &job) const -> void;
+    static constexpr int Slots = 2;
+    QVector<Job> m_jobs;
+    QVector<quint32> m_temp;
+    Slot *m_slots = nullptr;
+    int m_next = 0;
+    bool m_created = false, m_pbo = false;
+};
+
+#endif // OPENGLTEXTUREUPLOADER_HPP
@@ -29,7 +29,7 @@ auto set_window_title(QWidget *w, const QString &title) -> void
 }
 
 enum class LineCmd {
-    Wake, Open, Action, LogLevel, OpenGLDebug, Debug
+    Wake, Open, Action, LogLevel, LogContext, LogFile, OpenGLDebug, Debug
 };
 
 struct App::Data {
@@ -57,7 +57,7 @@ struct App::Data {
     LocalConnection connection = {u"net.xylosper.bomi"_q, nullptr};
     auto open(const Mrl &mrl) -> void
     {
-        if (!main || !main->isSceneGraphInitialized())
+        if (!main || !main->isInitialized())
             pended = mrl;
         else
             main->openFromFileManager(mrl);
@@ -87,6 +87,13 @@ struct App::Data {
             { return parser->values(options.value(cmd, dummy)); };
         if (isSet(LineCmd::LogLevel))
             Log::setMaximumLevel(value(LineCmd::LogLevel));
+        if (isSet(LineCmd::LogContext))
+            Log::setContexts(value(LineCmd::LogContext).split(','_q));
+        if (isSet(LineCmd::LogFile)) {
+            const auto file = value(LineCmd::LogFile);
+            if (!Log::setFile(file))
+                _Error("Cannot open log file: %%", file);
+        }
         if (isSet(LineCmd::OpenGLDebug))
             gldebug = true;
         if (main) {
@@ -194,6 +201,11 @@ App::App(int &argc, char **argv)
     d->addOption(LineCmd::LogLevel, u"log-level"_q,
                  tr("Maximum verbosity for log. %1 should be one of nexts:")
                  % "\n    "_a % Log::options().join(u", "_q), u"lv"_q);
+    d->addOption(LineCmd::LogContext, u"log-context"_q,
+                 tr("Write logs of given contexts only. "
+                    "%1 is comma-separated list of them."), u"ctx"_q);
+    d->addOption(LineCmd::LogFile, u"log-file"_q,
+                 tr("Write logs to %1 in JSON lines, too."), u"file"_q);
     d->addOption(LineCmd::OpenGLDebug, u"opengl-debug"_q,
                  tr("Turn on OpenGL debug logger."));
     d->addOption(LineCmd::Debug, u"debug"_q,
@@ -280,7 +292,7 @@ auto App::setMainWindow(MainWindow *mw) -> void
 #ifndef Q_OS_MAC
     d->main->setWindowIcon(defaultIcon());
 #endif
-    connect(d->main, &MainWindow::sceneGraphInitialized, this, [this] () {
+    connect(d->main, &MainWindow::initialized, this, [this] () {
         if (!d->pended.isEmpty()) {
             d->main->openFromFileManager(d->pended);
             d->pended = Mrl();
@@ -49,6 +49,9 @@ struct AppX11::Data {
 
 AppX11::AppX11(QObject *parent)
 : QObject(parent), d(new Data) {
+    // second accuracy is enough; let them be coalesced with others
+    d->xssTimer.setTimerType(Qt::VeryCoarseTimer);
+    d->hbTimer.setTimerType(Qt::VeryCoarseTimer);
     d->xssTimer.setInterval(20000);
     connect(&d->xssTimer, &QTimer::timeout, this, [this] () {
         if (d->xss && d->display) {
@@ -149,28 +149,26 @@ VideoInfoObject::VideoInfoObject()
             this, &VideoInfoObject::delayedTimeChanged);
     connect(this, &VideoInfoObject::delayedFramesChanged,
             this, &VideoInfoObject::delayedTimeChanged);
-    connect(&m_timer, &QTimer::timeout, this, [=] () {
-        auto fps = 0.0;
-        if (m_dropped)
-            fps = m_dropped / (m_time.elapsed() * 1e-3);
-        if (_Change(m_droppedFps, fps))
-            emit droppedFpsChanged();
-    });
-    m_timer.setInterval(100);
 }
 
+// called for every rendered frame, so no timer is needed to refresh rate
 void VideoInfoObject::setDroppedFrames(int f)
 {
     if (f > 0 && m_dropped < 1) {
-        QMetaObject::invokeMethod(&m_timer, "start");
         m_time.restart();
-    } else if (f < 1 && m_timer.isActive()) {
-        QMetaObject::invokeMethod(&m_timer, "stop");
-        if (_Change(m_droppedFps, 0.0))
-            emit droppedFpsChanged();
-    }
+        m_updated = 0;
+    } else if (f < 1 && _Change(m_droppedFps, 0.0))
+        emit droppedFpsChanged();
     if (_Change(m_dropped, f))
         emit droppedFramesChanged();
+    if (m_dropped > 0) {
+        const int elapsed = m_time.elapsed();
+        if (elapsed - m_updated >= 100) {
+            m_updated = elapsed;
+            if (_Change(m_droppedFps, m_dropped / (elapsed * 1e-3)))
+                emit droppedFpsChanged();
+        }
+    }
 }
 
 /******************************************************************************/
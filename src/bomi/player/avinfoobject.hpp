@@ -314,7 +314,7 @@ private:
     VideoHwAccInfoObject m_hwacc;
     int m_deint = 0, m_dropped = 0, m_delayed = 0;
     qreal m_droppedFps = 0.0;
-    QTime m_time; QTimer m_timer;
+    QTime m_time; int m_updated = 0;
 };
 
 /******************************************************************************/
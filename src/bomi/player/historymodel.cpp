@@ -1,5 +1,6 @@
 #include "historymodel.hpp"
 #include "mrlstatesqlfield.hpp"
+#include "historywriter.hpp"
 #include "misc/log.hpp"
 
 DECLARE_LOG_CONTEXT(History)
@@ -36,22 +37,33 @@ private:
 
 auto reg_history_model() -> void { qmlRegisterType<HistoryModel>(); }
 
-struct RowCache { Mrl mrl; int row = -1; };
+// 4: enums and structures are stored in binary instead of names and JSON
+static constexpr auto currentVersion = MrlState::Version + 2;
 
-static constexpr auto currentVersion = MrlState::Version + 1;
+// rows are loaded by pages which are continued from the last row of
+// previous page so that deep pages do not need OFFSET scan. last rows of
+// pages are kept as anchors even after the pages are evicted
+static constexpr int PageSize = 64;
+static constexpr int PageCacheSize = 32;
+
+struct HistoryRow { QString key; Mrl mrl; qint64 last = 0; };
+struct HistoryAnchor { QString key; qint64 last = 0; };
+using HistoryPage = QVector<HistoryRow>;
 
 struct HistoryModel::Data {
     HistoryModel *p = nullptr;
     QSqlDatabase db;
-    RowCache rowCache;
-    QSqlQuery loader, finder;
+    HistoryWriter *writer = nullptr;
+    QCache<int, HistoryPage> pages{PageCacheSize};
+    QVector<HistoryAnchor> anchors; // last row of each page from the top
+    QSqlQuery first, next, walkFirst, walkNext, counter, finder;
     QSqlError error;
     MrlStateSqlFieldList fields, restores;
-    MrlState cached;
-    const MrlState default_{};
+    MrlState cached; // last state read or written
+    QVector<QVariant> cachedData; // sqlData of cached
     const QString table = "state"_a % _N(currentVersion);
-    bool rememberImage = false, reload = true, visible = false;
-    int idx_mrl, idx_last, idx_device, rows = 0;
+    bool rememberImage = false, visible = false;
+    int rows = 0;
     auto check(const QSqlQuery &query) -> bool
     {
         if (!query.lastError().isValid())
@@ -63,41 +75,163 @@ struct HistoryModel::Data {
     auto insert(const MrlState *state) -> bool
     {
         if (state->mrl == cached.mrl)
-            cached.mrl = Mrl();
+            uncache();
         fields.insert(finder, state);
         return check(finder);
     }
-    auto load() -> bool
+    // fills cached with values which have not been written yet
+    auto fetchPending(const Mrl &mrl) -> bool
     {
-        const QString select = QString::fromLatin1(
-            "SELECT mrl, last_played_date_time, device, "
-            "(SELECT COUNT(*) FROM %1) as total "
-            "FROM %2 ORDER BY last_played_date_time DESC"
-        );
-        if (!loader.exec(select.arg(table).arg(table)))
+        if (!writer)
             return false;
-        Q_ASSERT(!loader.isForwardOnly());
-        p->beginResetModel();
-        rows = 0;
-        if (loader.next()) {
-            rows = loader.value(u"total"_q).toInt();
-            idx_mrl = 0;
-            idx_last = 1;
-            idx_device = 2;
-            loader.seek(-1);
-        }
-        error = QSqlError();
-        p->endResetModel();
-        reload = false;
-        rowCache = RowCache();
+        auto values = writer->pending(mrl.toString());
+        if (values.isEmpty())
+            return false;
+        fields.exportTo(&cached, values);
+        cached.mrl = mrl;
+        cachedData = std::move(values);
         return true;
     }
+    auto uncache() -> void
+    {
+        cached.mrl = Mrl();
+        cachedData.clear();
+    }
+    auto prepare() -> void
+    {
+        const auto select = u"SELECT %1 FROM %2 %3 ORDER BY "
+                            "last_played_date_time DESC, mrl DESC LIMIT %4"_q;
+        auto init = [&] (QSqlQuery &query, const QString &columns,
+                         const QString &where, const QString &limit) {
+            query = QSqlQuery(db);
+            query.setForwardOnly(true);
+            query.prepare(select.arg(columns, table, where, limit));
+            check(query);
+        };
+        const auto row = u"mrl, last_played_date_time, device"_q;
+        const auto after = u"WHERE last_played_date_time < :last1 OR "
+                           "(last_played_date_time = :last2 AND mrl < :mrl)"_q;
+        init(first, row, QString(), _N(PageSize));
+        init(next, row, after, _N(PageSize));
+        // walks the index only to find anchors
+        const auto anchor = u"mrl, last_played_date_time"_q;
+        init(walkFirst, anchor, QString(), u":limit"_q);
+        init(walkNext, anchor, after, u":limit"_q);
+        counter = QSqlQuery(db);
+        counter.setForwardOnly(true);
+        counter.prepare("SELECT COUNT(*) FROM "_a % table);
+    }
+    auto count() -> int
+    {
+        if (!counter.exec() || !counter.next())
+            return 0;
+        const int count = counter.value(0).toInt();
+        counter.finish();
+        return count;
+    }
+    auto bindAfter(QSqlQuery &query, const HistoryAnchor &anchor) -> void
+    {
+        query.bindValue(u":last1"_q, anchor.last);
+        query.bindValue(u":last2"_q, anchor.last);
+        query.bindValue(u":mrl"_q, anchor.key);
+    }
+    // finds anchors up to given page by walking from the last known one,
+    // so that each row is walked once until the order changes
+    auto reach(int index) -> bool
+    {
+        if (index < anchors.size())
+            return true;
+        auto &query = anchors.isEmpty() ? walkFirst : walkNext;
+        if (!anchors.isEmpty())
+            bindAfter(query, anchors.last());
+        query.bindValue(u":limit"_q, (index + 1 - anchors.size()) * PageSize);
+        if (!query.exec()) {
+            check(query);
+            return false;
+        }
+        for (int i = 1; query.next(); ++i) {
+            if (i % PageSize == 0)
+                anchors.push_back({ query.value(0).toString(),
+                                    query.value(1).toLongLong() });
+        }
+        query.finish();
+        return index < anchors.size();
+    }
+    auto page(int index) -> const HistoryPage*
+    {
+        if (auto page = pages.object(index))
+            return page;
+        QSqlQuery *query = &first;
+        if (index > 0) {
+            if (!reach(index - 1))
+                return nullptr;
+            query = &next;
+            bindAfter(*query, anchors[index - 1]);
+        }
+        if (!query->exec()) {
+            check(*query);
+            return nullptr;
+        }
+        auto page = new HistoryPage;
+        page->reserve(PageSize);
+        while (query->next()) {
+            HistoryRow row;
+            row.key = query->value(0).toString();
+            row.mrl = Mrl::fromUniqueId(row.key, query->value(2).toString());
+            row.last = query->value(1).toLongLong();
+            page->push_back(row);
+        }
+        query->finish();
+        if (page->size() == PageSize && anchors.size() == index)
+            anchors.push_back({ page->last().key, page->last().last });
+        pages.insert(index, page);
+        return page;
+    }
+    auto row(int row) -> const HistoryRow*
+    {
+        if (!_InRange0(row, rows))
+            return nullptr;
+        auto page = this->page(row / PageSize);
+        if (!page || row % PageSize >= page->size())
+            return nullptr;
+        return &page->at(row % PageSize);
+    }
+    auto written(const QVector<HistoryWriter::Move> &moves,
+                 bool cleared) -> void
+    {
+        pages.clear();
+        anchors.clear();
+        if (cleared) {
+            p->beginResetModel();
+            rows = moves.size();
+            p->endResetModel();
+            return;
+        }
+        for (auto &move : moves) {
+            if (move.from < 0) {
+                p->beginInsertRows(QModelIndex(), move.to, move.to);
+                ++rows;
+                p->endInsertRows();
+            } else if (move.from == move.to) {
+                emit p->dataChanged(p->index(move.to, 0),
+                                    p->index(move.to, p->columnCount() - 1));
+            } else {
+                // destination is the row which moved one is placed before
+                const int dest = move.to > move.from ? move.to + 1 : move.to;
+                p->beginMoveRows(QModelIndex(), move.from, move.from,
+                                 QModelIndex(), dest);
+                p->endMoveRows();
+                emit p->dataChanged(p->index(move.to, 0),
+                                    p->index(move.to, p->columnCount() - 1));
+            }
+        }
+    }
     auto import(const QVector<MrlState*> &states) -> void
     {
         Transactor t(&db);
         finder.exec(u"DROP TABLE IF EXISTS %1"_q.arg(table));
         QString columns = _ToStringList(fields, [] (const MrlStateSqlField &f) {
-            return QString(_L(f.property().name()) % ' '_q % f.type());
+            return QString(f.name() % ' '_q % f.type());
         }).join(u", "_q);
 
         finder.exec(u"CREATE TABLE %1 (%2)"_q.arg(table).arg(columns));
@@ -106,27 +240,15 @@ struct HistoryModel::Data {
             delete state;
         }
     }
-    auto getMrl() const -> Mrl
-    {
-        const auto id = loader.value(idx_mrl).toString();
-        const auto dev = loader.value(idx_device).toString();
-        return Mrl::fromUniqueId(id, dev);
-    }
 };
 
 HistoryModel::HistoryModel(QObject *parent)
 : QAbstractTableModel(parent), d(new Data) {
     d->p = this;
-    auto &metaObject = MrlState::staticMetaObject;
-    const int count = metaObject.propertyCount();
-    const int offset = metaObject.propertyOffset();
-    Q_ASSERT(offset == 1);
-    d->fields.reserve(count - offset);
-    for (int i=offset; i<count; ++i) {
-        const auto property = metaObject.property(i);
-        const auto def = property.read(&d->default_);
-        d->fields.push_back(property, def);
-    }
+    const auto fields = MrlStateSqlField::list();
+    d->fields.reserve(fields.size());
+    for (auto &field : fields)
+        d->fields.push_back(field);
     d->fields.prepareInsert(d->table);
     d->fields.prepareSelect(d->table, d->fields.field(u"mrl"_q));
 
@@ -138,7 +260,6 @@ HistoryModel::HistoryModel(QObject *parent)
         return;
     }
 
-    d->loader = QSqlQuery(d->db);
     d->finder = QSqlQuery(d->db);
 
     d->finder.exec(u"PRAGMA journal_mode = WAL"_q);
@@ -153,23 +274,31 @@ HistoryModel::HistoryModel(QObject *parent)
         auto record = d->db.record(d->table);
         QVector<MrlStateSqlField> lacks;
         for (const auto &field : d->fields) {
-            if (!record.contains(_L(field.property().name())))
+            if (!record.contains(field.name()))
                 lacks.append(field);
         }
         if (!lacks.isEmpty()) {
             Transactor t(&d->db);
             for (auto &field : lacks) {
                 const auto query = u"ALTER TABLE %3 ADD COLUMN %1 %2"_q
-                        .arg(_L(field.property().name())).arg(field.type());
+                        .arg(field.name()).arg(field.type());
                 d->finder.exec(query.arg(d->table));
                 d->check(d->finder);
             }
         }
     }
-    d->load();
+    d->prepare();
+    d->rows = d->count();
+
+    d->writer = new HistoryWriter(d->db.databaseName(), d->table,
+                                  d->fields.names());
+    connect(d->writer, &HistoryWriter::written, this,
+            [=] (const QVector<HistoryWriter::Move> &moves, bool cleared)
+            { d->written(moves, cleared); });
 }
 
 HistoryModel::~HistoryModel() {
+    delete d->writer;
     delete d;
 }
 
@@ -190,10 +319,10 @@ auto HistoryModel::getState(MrlState *state) const -> bool
     if (d->restores.isEmpty())
         return true;
     Q_ASSERT(d->restores.isSelectPrepared());
-    if (d->cached.mrl != state->mrl)
+    if (d->cached.mrl != state->mrl && !d->fetchPending(state->mrl))
         return d->restores.select(d->finder, state);
     for (auto &f : d->restores)
-        f.property().write(state, f.property().read(&d->cached));
+        f.copy(state, &d->cached);
     return true;
 }
 
@@ -201,10 +330,10 @@ auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
 {
     if (!mrl.isUnique())
         return nullptr;
-    if (d->cached.mrl == mrl)
+    if (d->cached.mrl == mrl || d->fetchPending(mrl))
         return &d->cached;
     Q_ASSERT(d->fields.isSelectPrepared());
-    if (!d->fields.select(d->finder, &d->cached, mrl))
+    if (!d->fields.select(d->finder, &d->cached, mrl, &d->cachedData))
         return nullptr;
     d->cached.mrl = mrl;
     return &d->cached;
@@ -212,38 +341,22 @@ auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
 
 auto HistoryModel::play(int row) -> void
 {
-    if (_InRange0(row, d->rows) && d->loader.seek(row))
-        emit playRequested(d->getMrl());
+    if (auto r = d->row(row))
+        emit playRequested(r->mrl);
 }
 
 auto HistoryModel::data(const QModelIndex &index, int role) const -> QVariant
 {
-    if (d->reload) {
-        d->load();
-        d->reload = false;
-    }
-    const int row = index.row();
-    if (!(0 <= row && row < d->rows))
+    const auto row = d->row(index.row());
+    if (!row)
         return QVariant();
-    if (!d->loader.seek(row))
-        return QVariant();
-    if (d->rowCache.row != row) {
-        d->rowCache.row = row;
-        d->rowCache.mrl = Mrl();
-    }
-    auto fillMrl = [this] () -> const Mrl& {
-        if (d->rowCache.mrl.isEmpty())
-            d->rowCache.mrl = d->getMrl();
-        return d->rowCache.mrl;
-    };
     switch (role) {
     case NameRole:
-        return fillMrl().displayName();
-    case LatestPlayRole: {
-        const auto msecs = d->loader.value(d->idx_last).toLongLong();
-        return QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODate);
-    } case LocationRole:
-        return fillMrl().toString();
+        return row->mrl.displayName();
+    case LatestPlayRole:
+        return QDateTime::fromMSecsSinceEpoch(row->last).toString(Qt::ISODate);
+    case LocationRole:
+        return row->mrl.toString();
     default:
         return QVariant();
     }
@@ -264,17 +377,17 @@ auto HistoryModel::error() const -> QSqlError
 }
 
 
-auto HistoryModel::update(const MrlState *state, bool reload) -> void
+auto HistoryModel::update(const MrlState *state) -> void
 {
     if (!d->rememberImage && state->mrl.isImage())
         return;
-    if (!state->mrl.isUnique())
+    if (!state->mrl.isUnique() || !d->writer)
         return;
-    Transactor t(&d->db);
-    d->insert(state);
-    t.done();
-    if (reload)
-        d->load();
+    // state is saved at start and end of playback with few changes
+    if (state->mrl != d->cached.mrl)
+        d->cachedData.clear();
+    d->fields.sync(&d->cached, d->cachedData, state);
+    d->writer->enqueue(QVector<QVariant>(d->cachedData));
 }
 
 auto HistoryModel::setRememberImage(bool on) -> void
@@ -296,10 +409,10 @@ auto HistoryModel::setPropertiesToRestore(const QVector<QMetaProperty> &properti
 
 auto HistoryModel::clear() -> void
 {
-    Transactor t(&d->db);
-    d->loader.exec("DELETE FROM "_a % d->table);
-    t.done();
-    d->load();
+    if (!d->writer)
+        return;
+    d->uncache();
+    d->writer->clear();
 }
 
 auto HistoryModel::isVisible() const -> bool
@@ -18,7 +18,8 @@ public:
     auto roleNames() const -> QHash<int, QByteArray>;
     auto find(const Mrl &mrl) const -> const MrlState*;
     auto getState(MrlState *state) const -> bool;
-    auto update(const MrlState *state, bool reload) -> void;
+    // written asynchronously and rows are inserted or moved when done
+    auto update(const MrlState *state) -> void;
     auto setRememberImage(bool on) -> void;
     auto setPropertiesToRestore(const QVector<QMetaProperty> &properties) -> void;
     auto clear() -> void;
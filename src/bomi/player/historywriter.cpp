@@ -0,0 +1,239 @@
+#include "historywriter.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(History)
+
+enum EventType { Open = QEvent::User + 1, Schedule, Close };
+
+// rows enqueued in this interval are written in a transaction
+static constexpr int BatchInterval = 200;
+
+struct HistoryWriter::Data {
+    HistoryWriter *p = nullptr;
+    QThread thread;
+    QString connection, table;
+    QStringList columns;
+    QSqlDatabase db;
+    QSqlQuery insert, exists, rank;
+    int timer = 0, lastColumn = -1;
+
+    mutable QMutex mutex;
+    QHash<QString, QVector<QVariant>> rows;
+    // rows being written, still pending until transaction is committed
+    QHash<QString, QVector<QVariant>> inflight;
+    QStringList order; // keys in order of enqueue
+    bool scheduled = false, clear = false;
+
+    auto check(bool ok, const QSqlQuery &query) -> bool
+    {
+        if (!ok)
+            _Error("Error on query: %% for %%",
+                   query.lastError().text(), query.lastQuery());
+        return ok;
+    }
+    auto open(const QString &fileName) -> void
+    {
+        db = QSqlDatabase::addDatabase(u"QSQLITE"_q, connection);
+        db.setDatabaseName(fileName);
+        if (!db.open()) {
+            _Error("Error: %%. Couldn't open database for writing.",
+                   db.lastError().text());
+            return;
+        }
+        QSqlQuery query(db);
+        query.exec(u"PRAGMA journal_mode = WAL"_q);
+        // WAL is kept consistent without syncing on every commit
+        query.exec(u"PRAGMA synchronous = NORMAL"_q);
+        // covers keyset pagination of HistoryModel
+        const auto index = u"CREATE INDEX IF NOT EXISTS %1_recent "
+                           "ON %1 (last_played_date_time, %2)"_q;
+        check(query.exec(index.arg(table, columns.first())), query);
+        exists = QSqlQuery(db);
+        exists.setForwardOnly(true);
+        check(exists.prepare(u"SELECT last_played_date_time FROM %1 "
+                              "WHERE %2 = ?"_q.arg(table, columns.first())),
+              exists);
+        // number of rows before given one in order of HistoryModel
+        rank = QSqlQuery(db);
+        rank.setForwardOnly(true);
+        check(rank.prepare(u"SELECT COUNT(*) FROM %1 WHERE "
+                            "last_played_date_time > ? OR "
+                            "(last_played_date_time = ? AND %2 > ?)"_q
+                           .arg(table, columns.first())), rank);
+        QStringList phs;
+        for (int i = 0; i < columns.size(); ++i)
+            phs.push_back(u"?"_q);
+        insert = QSqlQuery(db);
+        check(insert.prepare(u"INSERT OR REPLACE INTO %1 (%2) VALUES (%3)"_q
+                             .arg(table, columns.join(','_q), phs.join(','_q))),
+              insert);
+    }
+    auto position(const QVariant &last, const QVariant &key) -> int
+    {
+        rank.bindValue(0, last);
+        rank.bindValue(1, last);
+        rank.bindValue(2, key);
+        if (!check(rank.exec(), rank) || !rank.next())
+            return -1;
+        const int pos = rank.value(0).toInt();
+        rank.finish();
+        return pos;
+    }
+    auto write() -> void
+    {
+        mutex.lock();
+        const bool clear = this->clear;
+        const auto order = std::move(this->order);
+        const auto rows = std::move(this->rows);
+        inflight = rows;
+        this->order.clear();
+        this->rows.clear();
+        this->clear = scheduled = false;
+        mutex.unlock();
+        auto done = [&] () {
+            mutex.lock();
+            inflight.clear();
+            mutex.unlock();
+        };
+        if (!db.isOpen() || (!clear && order.isEmpty()))
+            return done();
+        if (!db.transaction()) {
+            _Error("Error on transaction(): %%", db.lastError().text());
+            return done();
+        }
+        bool ok = true;
+        QVector<Move> moves;
+        moves.reserve(order.size());
+        if (clear) {
+            QSqlQuery query(db);
+            ok = check(query.exec("DELETE FROM "_a % table), query);
+        }
+        for (int i = 0; ok && i < order.size(); ++i) {
+            const auto values = rows.value(order[i]);
+            Move move;
+            if (!clear) {
+                exists.bindValue(0, values.first());
+                ok = check(exists.exec(), exists);
+                if (ok && exists.next()) {
+                    move.from = position(exists.value(0), values.first());
+                    ok = move.from >= 0;
+                }
+                exists.finish();
+            }
+            for (int j = 0; ok && j < values.size(); ++j)
+                insert.bindValue(j, values[j]);
+            ok = ok && check(insert.exec(), insert);
+            if (ok && !clear) {
+                move.to = position(values[lastColumn], values.first());
+                ok = move.to >= 0;
+            }
+            moves.push_back(move);
+        }
+        if (!ok || !db.commit()) {
+            _Error("Error on commit(): %%", db.lastError().text());
+            db.rollback();
+            return done();
+        }
+        done();
+        emit p->written(moves, clear);
+    }
+    auto schedule() -> void
+    {
+        if (_Change(scheduled, true))
+            _PostEvent(p, Schedule);
+    }
+};
+
+HistoryWriter::HistoryWriter(const QString &fileName, const QString &table,
+                             const QStringList &columns)
+    : d(new Data)
+{
+    d->p = this;
+    d->connection = u"history-writer"_q;
+    d->table = table;
+    d->columns = columns;
+    d->lastColumn = columns.indexOf(u"last_played_date_time"_q);
+    Q_ASSERT(d->lastColumn >= 0);
+    qRegisterMetaType<QVector<HistoryWriter::Move>>();
+    moveToThread(&d->thread);
+    d->thread.start(QThread::LowPriority);
+    _PostEvent(this, Open, fileName);
+}
+
+HistoryWriter::~HistoryWriter()
+{
+    _PostEvent(this, Close);
+    d->thread.wait();
+    QSqlDatabase::removeDatabase(d->connection);
+    delete d;
+}
+
+auto HistoryWriter::enqueue(QVector<QVariant> &&values) -> void
+{
+    Q_ASSERT(values.size() == d->columns.size());
+    const auto key = values.first().toString();
+    d->mutex.lock();
+    auto it = d->rows.find(key);
+    if (it == d->rows.end()) {
+        d->order.push_back(key);
+        d->rows.insert(key, std::move(values));
+    } else
+        *it = std::move(values);
+    d->schedule();
+    d->mutex.unlock();
+}
+
+auto HistoryWriter::pending(const QVariant &key) const -> QVector<QVariant>
+{
+    const auto k = key.toString();
+    QMutexLocker locker(&d->mutex);
+    auto it = d->rows.constFind(k);
+    if (it != d->rows.cend())
+        return *it;
+    return d->inflight.value(k);
+}
+
+auto HistoryWriter::clear() -> void
+{
+    d->mutex.lock();
+    d->rows.clear();
+    d->inflight.clear(); // will be deleted by next write
+    d->order.clear();
+    d->clear = true;
+    d->schedule();
+    d->mutex.unlock();
+}
+
+auto HistoryWriter::customEvent(QEvent *event) -> void
+{
+    switch ((int)event->type()) {
+    case Open:
+        d->open(_GetData<QString>(event));
+        break;
+    case Schedule:
+        if (!d->timer)
+            d->timer = startTimer(BatchInterval);
+        break;
+    case Close:
+        if (d->timer)
+            killTimer(d->timer);
+        d->write();
+        d->insert = d->exists = d->rank = QSqlQuery();
+        d->db.close();
+        d->db = QSqlDatabase();
+        d->thread.quit();
+        break;
+    default:
+        QObject::customEvent(event);
+    }
+}
+
+auto HistoryWriter::timerEvent(QTimerEvent *event) -> void
+{
+    if (event->timerId() != d->timer)
+        return QObject::timerEvent(event);
+    killTimer(d->timer);
+    d->timer = 0;
+    d->write();
+}
@@ -0,0 +1,33 @@
+#ifndef HISTORYWRITER_HPP
+#define HISTORYWRITER_HPP
+
+// writes rows of history table in its own thread. rows are batched and
+// written in a transaction shortly after they are enqueued.
+class HistoryWriter : public QObject {
+    Q_OBJECT
+public:
+    // position of a row in order of recent play. from is -1 for new row
+    struct Move { int from = -1, to = -1; };
+    // first column is the key for INSERT OR REPLACE
+    HistoryWriter(const QString &fileName, const QString &table,
+                  const QStringList &columns);
+    ~HistoryWriter();
+    // values are bound to columns in order
+    auto enqueue(QVector<QVariant> &&values) -> void;
+    // values not written yet for the key, empty if none
+    auto pending(const QVariant &key) const -> QVector<QVariant>;
+    // deletes all rows before writing ones enqueued after this
+    auto clear() -> void;
+signals:
+    // moves are applied one after another in order
+    void written(const QVector<HistoryWriter::Move> &moves, bool cleared);
+private:
+    auto customEvent(QEvent *event) -> void override;
+    auto timerEvent(QTimerEvent *event) -> void override;
+    struct Data;
+    Data *d;
+};
+
+Q_DECLARE_METATYPE(HistoryWriter::Move)
+
+#endif // HISTORYWRITER_HPP
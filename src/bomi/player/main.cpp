@@ -4,6 +4,7 @@
 #include "video/hwacc.hpp"
 #include "misc/log.hpp"
 #include "misc/json.hpp"
+#include "misc/startuptimeline.hpp"
 #include "quick/circularimageitem.hpp"
 #include "quick/maskareaitem.hpp"
 
@@ -19,6 +20,7 @@ auto reg_app_object() -> void;
 auto reg_settings_object() -> void;
 auto reg_theme_object() -> void;
 auto reg_play_engine() -> void;
+auto reg_subtitle_renderer_item() -> void;
 
 namespace Pch {
 extern QStringList writableImageExts;
@@ -50,8 +52,10 @@ int main(int argc, char **argv) {
     reg_app_object();
     reg_settings_object();
     reg_play_engine();
+    reg_subtitle_renderer_item();
 
     App app(argc, argv);
+    StartupTimeline::mark("application");
     for (auto fmt : QImageWriter::supportedImageFormats())
         writableImageExts.push_back(QString::fromLatin1(fmt));
 
@@ -63,9 +67,12 @@ int main(int argc, char **argv) {
 
     OGL::check();
     HwAcc::initialize();
+    StartupTimeline::mark("OpenGL and hwacc check");
     MainWindow *mw = new MainWindow;
+    StartupTimeline::mark("main window");
     _Debug("Show MainWindow.");
     mw->show();
+    StartupTimeline::mark("show");
     app.setMainWindow(mw);
     _Debug("Start main event loop.");
     auto ret = app.exec();
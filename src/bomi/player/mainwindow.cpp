@@ -3,6 +3,7 @@
 #include "misc/trayicon.hpp"
 #include "dialog/mbox.hpp"
 #include "quick/appobject.hpp"
+#include "misc/startuptimeline.hpp"
 
 //DECLARE_LOG_CONTEXT(Main)
 
@@ -15,21 +16,25 @@ MainWindow::MainWindow(QWidget *parent)
     : QWidget(parent, Qt::Window)
     , d(new Data(this))
 {
+    StartupTimeline::mark("main window data");
     AppObject::setEngine(&d->engine);
     AppObject::setHistory(&d->history);
     AppObject::setPlaylist(&d->playlist);
     AppObject::setDownloader(&d->downloader);
     AppObject::setTheme(&d->theme);
+    AppObject::setSubtitle(&d->subtitle);
     d->playlist.setDownloader(&d->downloader);
 
     d->engine.setYouTube(&d->youtube);
     d->engine.setYle(&d->yle);
     d->engine.run();
+    StartupTimeline::mark("engine ready");
     d->initWidget();
     d->initContextMenu();
     d->initTimers();
     d->initItems();
     d->initEngine();
+    StartupTimeline::mark("widgets and items");
 
     d->dontShowMsg = true;
     d->connectMenus();
@@ -202,9 +207,9 @@ auto MainWindow::togglePlayPause() -> void
     }
 }
 
-auto MainWindow::isSceneGraphInitialized() const -> bool
+auto MainWindow::isInitialized() const -> bool
 {
-    return d->sgInit;
+    return d->initialized;
 }
 
 auto MainWindow::setFullScreen(bool full) -> void
@@ -18,11 +18,12 @@ public:
     auto engine() const -> PlayEngine*;
     auto playlist() const -> PlaylistModel*;
     auto exit() -> void;
-    auto isSceneGraphInitialized() const -> bool;
+    // true when preferences have been applied to open files
+    auto isInitialized() const -> bool;
     auto resetMoving() -> void;
 signals:
     void fullscreenChanged(bool fs);
-    void sceneGraphInitialized();
+    void initialized();
 private:
     auto showEvent(QShowEvent *event) -> void;
     auto hideEvent(QHideEvent *event) -> void;
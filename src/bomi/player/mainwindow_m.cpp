@@ -11,6 +11,7 @@
 #include "dialog/snapshotdialog.hpp"
 #include "dialog/subtitlefinddialog.hpp"
 #include "dialog/encodingfiledialog.hpp"
+#include "misc/tracerecorder.hpp"
 
 template<class F>
 auto MainWindow::Data::plugStreamActions(Menu *menu, F func,
@@ -787,6 +788,13 @@ auto MainWindow::Data::connectMenus() -> void
         toggleTool("playinfo", as.playinfo_visible);
     });
     connect(tool[u"subtitle"_q], &QAction::triggered, p, [this] () {
+        if (!subtitleView) {
+            subtitleView = new SubtitleView(p);
+            subtitleView->setModels(subtitle.models());
+            subtitleView->setSearchTarget(&subtitle);
+            connect(subtitleView, &SubtitleView::seekRequested,
+                    &engine, &PlayEngine::seek);
+        }
         subtitleView->setVisible(!subtitleView->isVisible());
     });
     connect(tool[u"pref"_q], &QAction::triggered, p, [this] () {
@@ -816,6 +824,18 @@ auto MainWindow::Data::connectMenus() -> void
         subFindDlg->find(engine.mrl());
         subFindDlg->show();
     });
+    connect(tool[u"trace"_q], &QAction::triggered, p, [this] (bool on) {
+        if (on) {
+            TraceRecorder::start();
+            showMessage(tr("Recording trace events"));
+            return;
+        }
+        const auto file = _WritablePath(Location::Cache) % "/trace-"_a
+                % QDateTime::currentDateTime().toString(u"yyyyMMdd-HHmmss"_q)
+                % ".json"_a;
+        if (TraceRecorder::stop(file))
+            showMessage(tr("Trace events are saved in %1").arg(file));
+    });
     connect(tool[u"reload-skin"_q], &QAction::triggered,
             p, [=] () { reloadSkin(); });
     connect(tool[u"auto-exit"_q], &QAction::triggered, p, [this] (bool on) {
@@ -13,12 +13,14 @@
 #include "dialog/openmediafolderdialog.hpp"
 #include "dialog/subtitlefinddialog.hpp"
 #include "avinfoobject.hpp"
+#include "misc/startuptimeline.hpp"
 
 MainWindow::Data::Data(MainWindow *p)
     : p(p)
 {
     preferences.initialize();
     preferences.load();
+    StartupTimeline::mark("preferences loaded");
 }
 
 template<class List>
@@ -90,7 +92,6 @@ auto MainWindow::Data::initWidget() -> void
     p->setFocus();
 //        widget->setFocus();
 
-    subtitleView = new SubtitleView(p);
     p->setAcceptDrops(true);
     p->resize(400, 300);
     p->setMinimumSize(QSize(400, 300));
@@ -99,12 +100,10 @@ auto MainWindow::Data::initWidget() -> void
         auto context = view->openglContext();
         if (cApp.isOpenGLDebugLoggerRequested())
             glLogger.initialize(context);
-        sgInit = true;
         engine.initializeGL(context);
-        emit p->sceneGraphInitialized();
+        StartupTimeline::mark("scene graph initialized");
     }, Qt::DirectConnection);
     connect(view, &QQuickView::sceneGraphInvalidated, p, [this] () {
-        sgInit = false;
         auto context = QOpenGLContext::currentContext();
         glLogger.finalize(context);
         engine.finalizeGL(context);
@@ -183,6 +182,52 @@ auto MainWindow::Data::initEngine() -> void
             menu(u"audio"_q)(u"volume"_q)[u"mute"_q], &QAction::setChecked);
     connect(engine.videoInfo()->output(), &VideoFormatInfoObject::fpsChanged,
             &subtitle, &SubtitleRendererItem::setFPS);
+    connect(&engine, &PlayEngine::speedChanged,
+            &subtitle, &SubtitleRendererItem::setSpeed);
+    connect(&subLoader, &SubtitleLoader::loaded,
+            p, [this] (const Subtitle &sub, bool select) {
+        const auto restored = restoring.take(sub);
+        if (restored.isEmpty())
+            subtitle.load(sub, select);
+        else
+            subtitle.addComponents(restored);
+        syncSubtitleFileMenu();
+    });
+    connect(&subLoader, &SubtitleLoader::failed,
+            p, [this] (const QString &file, const QString &enc) {
+        restoring.bomi().remove(SubtitleFileInfo(file, enc));
+        engine.addSubtitleStream(file, enc);
+    });
+    connect(&subAutoloader, &SubtitleAutoloader::finished,
+            p, [this] (const QString &file, const QVector<SubComp> &comps,
+                       const QStringList &failed, const QString &enc) {
+        if (file != autoloading)
+            return;
+        autoloading.clear();
+        // files added while scanning are kept as they are
+        QSet<QString> files;
+        for (auto comp : subtitle.components())
+            files.insert(comp->fileName());
+        for (auto &one : failed) {
+            if (!files.contains(one))
+                engine.addSubtitleStream(one, enc);
+        }
+        QVector<SubComp> loaded;
+        for (auto &comp : comps) {
+            if (!files.contains(comp.fileName()))
+                loaded.push_back(comp);
+        }
+        const auto selected = tryToAutoselect(loaded, as.state.mrl);
+        for (int i=0; i<selected.size(); ++i)
+            loaded[selected[i]].selection() = true;
+        subtitle.addComponents(loaded);
+        syncSubtitleFileMenu();
+    });
+    connect(&subLoader, &SubtitleLoader::progress,
+            p, [this] (const QString &file, double rate) {
+        showMessage(tr("Loading %1").arg(QFileInfo(file).fileName()),
+                    rate*100.0, u"%"_q);
+    });
     connect(&engine, &PlayEngine::editionsChanged,
             p, [this] (const EditionList &editions) {
         const auto edition = engine.currentEdition();
@@ -251,7 +296,7 @@ auto MainWindow::Data::initEngine() -> void
         as.state.mrl = mrl.toUnique();
         as.state.device = mrl.device();
         as.state.last_played_date_time = QDateTime::currentDateTime();
-        history.update(&as.state, true);
+        history.update(&as.state);
         as.state.mrl = mrl;
         starting = false;
     });
@@ -266,7 +311,7 @@ auto MainWindow::Data::initEngine() -> void
         as.state.sub_track = subtitleState();
         as.state.sub_track.setTrack(info.streamIds[StreamSubtitle]);
         syncState();
-        history.update(&as.state, false);
+        history.update(&as.state);
         as.state.mrl = info.mrl;
     });
     connect(engine.videoInfo()->renderer(), &VideoFormatInfoObject::sizeChanged,
@@ -294,7 +339,10 @@ auto MainWindow::Data::initItems() -> void
         if (menu(u"tool"_q)[u"auto-shutdown"_q]->isChecked()) cApp.shutdown();
     });
     connect(&subtitle, &SubtitleRendererItem::modelsChanged,
-            subtitleView, &SubtitleView::setModels);
+            p, [this] (const QVector<SubCompModel*> &models) {
+        if (subtitleView)
+            subtitleView->setModels(models);
+    });
 
     vr.setOverlay(&subtitle);
     auto showSize = [this] {
@@ -314,8 +362,19 @@ auto MainWindow::Data::initTimers() -> void
     connect(&waiter, &QTimer::timeout, p, [=] () { updateWaitingMessage(); });
 
     initializer.setSingleShot(true);
-    connect(&initializer, &QTimer::timeout,
-            p, [=] () { applyPref(); cApp.runCommands(); });
+    connect(&initializer, &QTimer::timeout, p, [=] () {
+        // files in command line are opened before compiling skin so that
+        // mpv can probe them meanwhile
+        applyPref(false);
+        StartupTimeline::mark("preferences applied");
+        initialized = true;
+        emit p->initialized();
+        cApp.runCommands();
+        reloadSkin();
+        StartupTimeline::mark("skin loaded");
+        if (!engine.startInfo().isValid())
+            StartupTimeline::finish("ready without file");
+    });
     initializer.start(1);
 }
 
@@ -419,57 +478,29 @@ auto MainWindow::Data::tryToAutoselect(const QVector<SubComp> &loaded,
     return selected;
 }
 
-auto MainWindow::Data::tryToAutoload(const Mrl &mrl,
-                                     const QDir &dir) -> QVector<SubComp>
+auto MainWindow::Data::autoloadOptions() const -> SubtitleAutoloader::Options
 {
-    QVector<SubComp> loaded;
     const auto &p = pref();
-    if (!p.sub_enable_autoload)
-        return loaded;
-    const QFileInfo fileInfo(mrl.toLocalFile());
-    if (!dir.exists())
-        return loaded;
-    static const auto filter = _ToNameFilter(SubtitleExt);
-    const auto all = dir.entryInfoList(filter, QDir::Files, QDir::Name);
-    const auto base = fileInfo.completeBaseName();
-    for (int i=0; i<all.size(); ++i) {
-        if (p.sub_autoload != SubtitleAutoload::Folder) {
-            if (p.sub_autoload == SubtitleAutoload::Matched) {
-                if (base != all[i].completeBaseName())
-                    continue;
-            } else if (!all[i].fileName().contains(base))
-                continue;
-        }
-        Subtitle sub;
-        if (load(sub, all[i].absoluteFilePath(), p.sub_enc)) {
-            for (int i=0; i<sub.size(); ++i)
-                loaded.push_back(sub[i]);
-        }
-    }
-    return loaded;
+    SubtitleAutoloader::Options options;
+    options.mode = p.sub_autoload;
+    options.enc = p.sub_enc;
+    options.accuracy = p.sub_enc_autodetection ? p.sub_enc_accuracy*0.01 : -1.0;
+    options.paths = p.sub_search_paths_v2;
+    return options;
 }
 
 auto MainWindow::Data::updateSubtitleState() -> void
 {
     const auto &mrl = as.state.mrl;
+    autoloading.clear();
     if (mrl.isLocalFile()) {
-        const QFileInfo fileInfo(mrl.toLocalFile());
-        auto root = fileInfo.dir();
-        auto loaded = tryToAutoload(mrl, root);
-        auto list = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-        for (auto &path : pref().sub_search_paths_v2) {
-            for (auto &one : list) {
-                if (path.match(one)) {
-                    auto dir = root;
-                    if (dir.cd(one))
-                        loaded += tryToAutoload(mrl, dir);
-                }
-            }
-        }
-        const auto selected = tryToAutoselect(loaded, mrl);
-        for (int i=0; i<selected.size(); ++i)
-            loaded[selected[i]].selection() = true;
-        subtitle.setComponents(loaded);
+        // captions are attached when autoloader finishes
+        subtitle.setComponents(QVector<SubComp>());
+        if (pref().sub_enable_autoload) {
+            autoloading = mrl.toLocalFile();
+            subAutoloader.request(autoloading, autoloadOptions());
+        } else
+            subAutoloader.cancel();
     } else
         clearSubtitleFiles();
     syncSubtitleFileMenu();
@@ -629,6 +660,10 @@ auto MainWindow::Data::subtitleState() const -> SubtitleStateInfo
     const auto parsed = subtitle.components();
     for (auto c : parsed)
         state.append(*c);
+    // files still being parsed keep their saved state
+    const auto &pending = restoring.bomi();
+    for (auto it = pending.begin(); it != pending.end(); ++it)
+        state.bomi().insert(it.key(), *it);
     return state;
 }
 
@@ -636,10 +671,18 @@ auto MainWindow::Data::setSubtitleState(const SubtitleStateInfo &state) -> void
 {
     if (!state.isValid())
         return;
+    // restored state replaces autoloaded and loading subtitles
+    subAutoloader.cancel();
+    autoloading.clear();
+    subLoader.cancel();
     for (auto &f : state.mpv())
         engine.addSubtitleStream(f.path, f.encoding);
-    auto loaded = state.load();
-    subtitle.setComponents(loaded);
+    // files are attached when parsed
+    subtitle.setComponents(QVector<SubComp>());
+    restoring = state;
+    const auto &files = state.bomi();
+    for (auto it = files.begin(); it != files.end(); ++it)
+        subLoader.load({ it.key().path }, it.key().encoding, -1.0, false);
     engine.setCurrentSubtitleStream(state.getTrack(), starting);
     syncSubtitleFileMenu();
 }
@@ -826,17 +869,18 @@ auto MainWindow::Data::appendSubFiles(const QStringList &files,
                                       bool checked, const QString &enc) -> void
 {
     if (!files.isEmpty()) {
-        Subtitle sub;
-        for (auto file : files) {
-            if (load(sub, file, enc))
-                subtitle.load(sub, checked);
-        }
-        syncSubtitleFileMenu();
+        const auto autodet = pref().sub_enc_autodetection;
+        const auto accuracy = autodet ? pref().sub_enc_accuracy*0.01 : -1.0;
+        subLoader.load(files, enc, accuracy, checked);
     }
 }
 
 auto MainWindow::Data::clearSubtitleFiles() -> void
 {
+    subLoader.cancel();
+    subAutoloader.cancel();
+    autoloading.clear();
+    restoring = SubtitleStateInfo();
     subtitle.unload();
     qDeleteAll(menu(u"subtitle"_q)(u"track"_q).g(u"external"_q)->actions());
     for (auto action : menu(u"subtitle"_q)(u"track"_q).g(u"internal"_q)->actions()) {
@@ -846,7 +890,7 @@ auto MainWindow::Data::clearSubtitleFiles() -> void
     }
 }
 
-auto MainWindow::Data::applyPref() -> void
+auto MainWindow::Data::applyPref(bool reload) -> void
 {
     auto &p = pref();
     youtube.setUserAgent(p.yt_user_agent);
@@ -855,6 +899,7 @@ auto MainWindow::Data::applyPref() -> void
     history.setRememberImage(p.remember_image);
     history.setPropertiesToRestore(p.restore_properties);
     engine.setHwAcc(p.enable_hwaccel, p.hwaccel_codecs);
+    engine.setAdaptiveDecoding(p.enable_adaptive_decoding);
     engine.setVolumeNormalizerOption(p.audio_normalizer);
     engine.setChannelLayoutMap(p.channel_manipulation);
     engine.setSubtitleStyle(p.sub_style);
@@ -910,8 +955,10 @@ auto MainWindow::Data::applyPref() -> void
 
     theme.osd()->set(p.osd_theme);
     theme.playlist()->set(p.playlist_theme);
-    reloadSkin();
-    engine.reload();
+    if (reload) {
+        reloadSkin();
+        engine.reload();
+    }
     if (tray)
         tray->setVisible(p.enable_system_tray);
     preferences.save();
@@ -958,6 +1005,13 @@ auto MainWindow::Data::load(const Mrl &mrl, bool play) -> void
 {
     StartInfo info;
     info.mrl = mrl;
+    // subtitles being autoloaded for previous file should not be attached.
+    // otherwise, scan for subtitles while engine opens the file
+    autoloading.clear();
+    if (play && info.mrl.isLocalFile() && pref().sub_enable_autoload)
+        subAutoloader.prefetch(info.mrl.toLocalFile(), autoloadOptions());
+    else
+        subAutoloader.cancel();
     if (play) {
         if (info.mrl.hash().isEmpty() && info.mrl.isDisc())
             info.mrl.updateHash();
@@ -967,17 +1021,6 @@ auto MainWindow::Data::load(const Mrl &mrl, bool play) -> void
     engine.load(info);
 }
 
-auto MainWindow::Data::load(Subtitle &sub, const QString &fileName,
-                      const QString &encoding) -> bool
-{
-    const auto autodet = pref().sub_enc_autodetection;
-    const auto accuracy = autodet ? pref().sub_enc_accuracy*0.01 : -1.0;
-    if (sub.load(fileName, encoding, accuracy))
-        return true;
-    engine.addSubtitleStream(fileName, encoding);
-    return false;
-}
-
 auto MainWindow::Data::reloadSkin() -> void
 {
     player = nullptr;
@@ -1058,6 +1101,7 @@ auto MainWindow::Data::updateTitle() -> void
 auto MainWindow::Data::doVisibleAction(bool visible) -> void
 {
     this->visible = visible;
+    engine.setVideoVisible(visible);
     if (visible) {
         if (pausedByHiding && engine.isPaused()) {
             engine.unpause();
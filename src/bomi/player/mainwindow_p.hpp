@@ -17,6 +17,8 @@
 #include "misc/yledl.hpp"
 #include "video/videorenderer.hpp"
 #include "subtitle/subtitlerendereritem.hpp"
+#include "subtitle/subtitleloader.hpp"
+#include "subtitle/subtitleautoloader.hpp"
 #include "opengl/opengllogger.hpp"
 #include "quick/themeobject.hpp"
 #include "misc/stepaction.hpp"
@@ -72,13 +74,17 @@ struct MainWindow::Data {
     QPoint prevPos;
     YouTubeDL youtube;
     YleDL yle;
+    SubtitleLoader subLoader;
+    SubtitleAutoloader subAutoloader;
+    QString autoloading;
+    SubtitleStateInfo restoring; // files left to be loaded by subLoader
 
     Qt::WindowStates winState = Qt::WindowNoState;
     Qt::WindowStates prevWinState = Qt::WindowNoState;
     Qt::MouseButton pressedButton = Qt::NoButton;
     bool moving = false, changingSub = false;
     bool pausedByHiding = false, dontShowMsg = true, dontPause = false;
-    bool stateChanging = false, loading = false, sgInit = false;
+    bool stateChanging = false, loading = false, initialized = false;
     QTimer waiter, hider, initializer;
     ABRepeatChecker ab;
     QMenu contextMenu;
@@ -111,7 +117,8 @@ struct MainWindow::Data {
     auto appendSubFiles(const QStringList &files, bool checked,
                         const QString &enc) -> void;
     auto clearSubtitleFiles() -> void;
-    auto applyPref() -> void;
+    // skin is not reloaded and current file is not restarted if !reload
+    auto applyPref(bool reload = true) -> void;
     auto updateStaysOnTop() -> void;
     auto setVideoSize(double rate) -> void;
     auto updateRecentActions(const QList<Mrl> &list) -> void;
@@ -143,14 +150,12 @@ struct MainWindow::Data {
     auto syncState() -> void;
     auto syncWithState() -> void;
     auto load(const Mrl &mrl, bool play = true) -> void;
-    auto load(Subtitle &sub, const QString &file, const QString &enc) -> bool;
     auto reloadSkin() -> void;
     auto trigger(QAction *action) -> void;
     auto updateSubtitleState() -> void;
     auto tryToAutoselect(const QVector<SubComp> &loaded,
                          const Mrl &mrl) -> QVector<int>;
-    auto tryToAutoload(const Mrl &mrl,
-                       const QDir &dir = QString()) -> QVector<SubComp>;
+    auto autoloadOptions() const -> SubtitleAutoloader::Options;
     auto cancelToHideCursor() -> void
         { hider.stop(); view->setCursorVisible(true); }
     auto readyToHideCursor() -> void;
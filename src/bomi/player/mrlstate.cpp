@@ -1,4 +1,5 @@
 #include "mrlstate.hpp"
+#include "mrlstatesqlfield.hpp"
 #include "misc/json.hpp"
 #include "misc/log.hpp"
 
@@ -131,33 +132,37 @@ auto MrlState::restorableProperties() -> QVector<PropertyInfo>
     return properties;
 }
 
-template<class F>
-static auto _MrlFieldColumnListString(const QList<F> &list) -> QString
-{
-    QString columns;
-    for (auto &f : list)
-        columns += _L(f.property().name()) % ", "_a;
-    columns.chop(2);
-    return columns;
-}
-
-template<class T = MrlState, class F>
-auto _FillMrlStateFromRecord(T *state, const QList<F> &fields,
-                             const QSqlRecord &record) -> void {
-    for (int i=0; i<fields.size(); ++i) {
-        const auto &f = fields[i];
-        const QMetaProperty p = f.property();
-        Q_ASSERT(_L(p.name()) == record.fieldName(i));
-        p.write(state, f.fromSql(record.value(i)));
-    }
-}
-
 auto _ImportMrlStates(int version, QSqlDatabase db)
 -> QVector<MrlState*>
 {
-    Q_UNUSED(db);
     QVector<MrlState*> states;
-    if (version < 3)
-        _Error("This version of history database is not supported.");
+    if (version < 3) {
+        if (version > 0)
+            _Error("This version of history database is not supported.");
+        return states;
+    }
+    // fields still accept enum names and JSON text of version 3
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(u"SELECT * FROM state%1"_q.arg(version))) {
+        _Error("Cannot import history: %%", query.lastError().text());
+        return states;
+    }
+    const auto record = query.record();
+    QVector<MrlStateSqlField> columns(record.count());
+    for (auto &field : MrlStateSqlField::list()) {
+        const int idx = record.indexOf(field.name());
+        if (idx >= 0)
+            columns[idx] = field;
+    }
+    while (query.next()) {
+        auto state = new MrlState;
+        for (int i = 0; i < columns.size(); ++i) {
+            if (columns[i].isValid())
+                columns[i].exportTo(state, query.value(i));
+        }
+        states.push_back(state);
+    }
+    _Info("%% states have been imported from version %%.", states.size(), version);
     return states;
 }
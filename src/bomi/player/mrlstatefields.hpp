@@ -0,0 +1,39 @@
+// generated from mrlstate-list by prebuild/enum-main.cpp
+// included only in mrlstatesqlfield.cpp
+
+static const MrlStateFieldIO MrlStateFields[] = {
+    _MrlStateField<decltype(MrlState::mrl), &MrlState::mrl>("mrl"),
+    _MrlStateField<decltype(MrlState::device), &MrlState::device>("device"),
+    _MrlStateField<decltype(MrlState::last_played_date_time), &MrlState::last_played_date_time>("last_played_date_time"),
+    _MrlStateField<decltype(MrlState::resume_position), &MrlState::resume_position>("resume_position"),
+    _MrlStateField<decltype(MrlState::edition), &MrlState::edition>("edition"),
+    _MrlStateField<decltype(MrlState::play_speed), &MrlState::play_speed>("play_speed"),
+    _MrlStateField<decltype(MrlState::video_interpolator), &MrlState::video_interpolator>("video_interpolator"),
+    _MrlStateField<decltype(MrlState::video_chroma_upscaler), &MrlState::video_chroma_upscaler>("video_chroma_upscaler"),
+    _MrlStateField<decltype(MrlState::video_aspect_ratio), &MrlState::video_aspect_ratio>("video_aspect_ratio"),
+    _MrlStateField<decltype(MrlState::video_crop_ratio), &MrlState::video_crop_ratio>("video_crop_ratio"),
+    _MrlStateField<decltype(MrlState::video_deinterlacing), &MrlState::video_deinterlacing>("video_deinterlacing"),
+    _MrlStateField<decltype(MrlState::video_dithering), &MrlState::video_dithering>("video_dithering"),
+    _MrlStateField<decltype(MrlState::video_offset), &MrlState::video_offset>("video_offset"),
+    _MrlStateField<decltype(MrlState::video_vertical_alignment), &MrlState::video_vertical_alignment>("video_vertical_alignment"),
+    _MrlStateField<decltype(MrlState::video_horizontal_alignment), &MrlState::video_horizontal_alignment>("video_horizontal_alignment"),
+    _MrlStateField<decltype(MrlState::video_color), &MrlState::video_color>("video_color"),
+    _MrlStateField<decltype(MrlState::video_range), &MrlState::video_range>("video_range"),
+    _MrlStateField<decltype(MrlState::video_space), &MrlState::video_space>("video_space"),
+    _MrlStateField<decltype(MrlState::video_hq_upscaling), &MrlState::video_hq_upscaling>("video_hq_upscaling"),
+    _MrlStateField<decltype(MrlState::video_hq_downscaling), &MrlState::video_hq_downscaling>("video_hq_downscaling"),
+    _MrlStateField<decltype(MrlState::audio_volume), &MrlState::audio_volume>("audio_volume"),
+    _MrlStateField<decltype(MrlState::audio_amplifier), &MrlState::audio_amplifier>("audio_amplifier"),
+    _MrlStateField<decltype(MrlState::audio_equalizer), &MrlState::audio_equalizer>("audio_equalizer"),
+    _MrlStateField<decltype(MrlState::audio_sync), &MrlState::audio_sync>("audio_sync"),
+    _MrlStateField<decltype(MrlState::audio_track), &MrlState::audio_track>("audio_track"),
+    _MrlStateField<decltype(MrlState::audio_muted), &MrlState::audio_muted>("audio_muted"),
+    _MrlStateField<decltype(MrlState::audio_volume_normalizer), &MrlState::audio_volume_normalizer>("audio_volume_normalizer"),
+    _MrlStateField<decltype(MrlState::audio_tempo_scaler), &MrlState::audio_tempo_scaler>("audio_tempo_scaler"),
+    _MrlStateField<decltype(MrlState::audio_channel_layout), &MrlState::audio_channel_layout>("audio_channel_layout"),
+    _MrlStateField<decltype(MrlState::sub_alignment), &MrlState::sub_alignment>("sub_alignment"),
+    _MrlStateField<decltype(MrlState::sub_display), &MrlState::sub_display>("sub_display"),
+    _MrlStateField<decltype(MrlState::sub_position), &MrlState::sub_position>("sub_position"),
+    _MrlStateField<decltype(MrlState::sub_sync), &MrlState::sub_sync>("sub_sync"),
+    _MrlStateField<decltype(MrlState::sub_track), &MrlState::sub_track>("sub_track"),
+};
@@ -6,96 +6,206 @@
 #include "audio/audioequalizer.hpp"
 #include "subtitle/submisc.hpp"
 
-template<class T>
-SIA _Is(int type) -> bool { return qMetaTypeId<T>() == type; }
+// values are bound as is or packed into integer or blob.
+// enums and structures had been stored as names and JSON text before
+// version 4, which are still accepted to import old table.
 
 template<class T>
-static auto _ValueToSqlDataUsingJson(const QVariant &value) -> QVariant
-    { return _JsonToString(json_io<T>()->toJson(value.value<T>())); }
+static auto _FromLegacyJson(T &t, const QVariant &data) -> bool
+    { return json_io<T>()->fromJson(t, _JsonFromString(data.toString())); }
+
+static auto _IsLegacy(const QVariant &data) -> bool
+    { return data.type() == QVariant::String; }
+
+template<class T, bool = tmp::is_enum_class<T>()>
+struct SqlCodec;
 
 template<class T>
-static auto _SqlDataToValueUsingJson(const QVariant &sqlData) -> QVariant
+struct SqlCodec<T, true> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(T t) -> QVariant { return (int)t; }
+    static auto fromSql(T &t, const QVariant &data) -> bool
+    {
+        if (_IsLegacy(data))
+            return EnumInfo<T>::fromName(t, data.toString());
+        bool ok = false;
+        const auto e = (T)data.toInt(&ok);
+        if (!ok || !EnumInfo<T>::item(e))
+            return false;
+        t = e;
+        return true;
+    }
+};
+
+template<>
+struct SqlCodec<int> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(int i) -> QVariant { return i; }
+    static auto fromSql(int &i, const QVariant &data) -> bool
+        { bool ok = false; i = data.toInt(&ok); return ok; }
+};
+
+template<>
+struct SqlCodec<bool> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(bool b) -> QVariant { return (int)b; }
+    static auto fromSql(bool &b, const QVariant &data) -> bool
+        { bool ok = false; b = data.toInt(&ok); return ok; }
+};
+
+template<>
+struct SqlCodec<QString> {
+    static constexpr auto type = "TEXT";
+    static auto toSql(const QString &s) -> QVariant { return s; }
+    static auto fromSql(QString &s, const QVariant &data) -> bool
+        { s = data.toString(); return true; }
+};
+
+template<>
+struct SqlCodec<QDateTime> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(const QDateTime &dt) -> QVariant
+        { return dt.toMSecsSinceEpoch(); }
+    static auto fromSql(QDateTime &dt, const QVariant &data) -> bool
+    {
+        bool ok = false;
+        dt = QDateTime::fromMSecsSinceEpoch(data.toLongLong(&ok));
+        return ok;
+    }
+};
+
+template<>
+struct SqlCodec<Mrl> {
+    static constexpr auto type = "TEXT PRIMARY KEY NOT NULL";
+    static auto toSql(const Mrl &mrl) -> QVariant { return mrl.toString(); }
+    static auto fromSql(Mrl &mrl, const QVariant &data) -> bool
+    {
+        if (data.isNull() || !data.isValid())
+            return false;
+        mrl = Mrl::fromString(data.toString());
+        return true;
+    }
+};
+
+// x and y in each 32 bits
+template<>
+struct SqlCodec<QPoint> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(const QPoint &p) -> QVariant
+    {
+        // pack unsigned since shifting negative values is undefined
+        const quint64 v = ((quint64)(quint32)p.x() << 32) | (quint32)p.y();
+        return (qint64)v;
+    }
+    static auto fromSql(QPoint &p, const QVariant &data) -> bool
+    {
+        if (_IsLegacy(data))
+            return _FromLegacyJson(p, data);
+        bool ok = false;
+        const auto v = (quint64)data.toLongLong(&ok);
+        p = { (qint32)(quint32)(v >> 32), (qint32)(quint32)v };
+        return ok;
+    }
+};
+
+// each value in [-100, 100] takes 16 bits
+template<>
+struct SqlCodec<VideoColor> {
+    static constexpr auto type = "INTEGER";
+    static auto toSql(const VideoColor &color) -> QVariant
+    {
+        quint64 v = 0;
+        for (int i = 0; i < VideoColor::TypeMax; ++i)
+            v |= (quint64)(quint16)color[(VideoColor::Type)i] << (16 * i);
+        return (qint64)v;
+    }
+    static auto fromSql(VideoColor &color, const QVariant &data) -> bool
+    {
+        if (_IsLegacy(data))
+            return _FromLegacyJson(color, data);
+        bool ok = false;
+        const auto v = (quint64)data.toLongLong(&ok);
+        for (int i = 0; i < VideoColor::TypeMax; ++i)
+            color.set((VideoColor::Type)i, (qint16)(quint16)(v >> (16 * i)));
+        return ok;
+    }
+};
+
+// dB of bands in native double
+template<>
+struct SqlCodec<AudioEqualizer> {
+    static constexpr auto type = "BLOB";
+    static auto toSql(const AudioEqualizer &eq) -> QVariant
+    {
+        QByteArray blob(sizeof(double) * eq.size(), Qt::Uninitialized);
+        auto dbs = reinterpret_cast<double*>(blob.data());
+        for (int i = 0; i < eq.size(); ++i)
+            dbs[i] = eq[i];
+        return blob;
+    }
+    static auto fromSql(AudioEqualizer &eq, const QVariant &data) -> bool
+    {
+        if (_IsLegacy(data))
+            return _FromLegacyJson(eq, data);
+        const auto blob = data.toByteArray();
+        if (blob.size() != (int)sizeof(double) * eq.size())
+            return false;
+        auto dbs = reinterpret_cast<const double*>(blob.constData());
+        for (int i = 0; i < eq.size(); ++i)
+            eq[i] = dbs[i];
+        return true;
+    }
+};
+
+// lists of files are rarely stored; JSON is kept for them
+template<>
+struct SqlCodec<SubtitleStateInfo> {
+    static constexpr auto type = "TEXT";
+    static auto toSql(const SubtitleStateInfo &info) -> QVariant
+        { return _JsonToString(json_io<SubtitleStateInfo>()->toJson(info)); }
+    static auto fromSql(SubtitleStateInfo &info, const QVariant &data) -> bool
+        { return _FromLegacyJson(info, data); }
+};
+
+static auto _MrlStateDefault() -> const MrlState&
 {
-    T t;
-    if (json_io<T>()->fromJson(t, _JsonFromString(sqlData.toString())))
-        return QVariant::fromValue<T>(t);
-    return QVariant();
+    static const MrlState state;
+    return state;
 }
 
-MrlStateSqlField::MrlStateSqlField(const QMetaProperty &property,
-                                   const QVariant &def) noexcept
-    : m_property(property)
-    , m_sqlType(u"INTEGER"_q)
-    , m_defaultValue(def)
+template<class T, T MrlState::*m>
+static auto _MrlStateField(const char *name) -> MrlStateFieldIO
 {
-    static const auto passthrough = [] (const QVariant &var) { return var; };
-    m_d2v = m_v2d = std::cref(passthrough);
-    switch (m_property.userType()) {
-    case QMetaType::Int:         case QMetaType::UInt:
-    case QMetaType::LongLong:    case QMetaType::ULongLong:
-        break;
-    case QMetaType::Double:
-        m_sqlType = u"REAL"_q;
-        break;
-    case QMetaType::QString:
-        m_sqlType = u"TEXT"_q;
-        break;
-    case QMetaType::Bool:
-        m_v2d = [] (const QVariant &value)
-            { return QVariant((int)value.toBool()); };
-        m_d2v = [] (const QVariant &sqlData)
-            { return QVariant((bool)sqlData.toInt()); };
-        break;
-    case QMetaType::QDateTime:
-        m_v2d = [] (const QVariant &value)
-            { return QVariant(value.toDateTime().toMSecsSinceEpoch()); };
-        m_d2v = [] (const QVariant &sqlData)
-            { return QDateTime::fromMSecsSinceEpoch(sqlData.toLongLong()); };
-        break;
-#define JSON_CASE_QT(type) \
-    {case QMetaType::type: \
-        m_v2d = _ValueToSqlDataUsingJson<type>; \
-        m_d2v = _SqlDataToValueUsingJson<type>; \
-        break;}
-    JSON_CASE_QT(QPoint);    JSON_CASE_QT(QPointF);
-    JSON_CASE_QT(QSize);     JSON_CASE_QT(QSizeF);
-#undef JSON_CASE
-    default: {
-        const auto type = m_property.userType();
-        const auto enumConv = _EnumNameVariantConverter(type);
-        if (!enumConv.isNull()) {
-            m_sqlType = u"TEXT"_q;
-            const auto n2v = enumConv.nameToVariant;
-            const auto v2n = enumConv.variantToName;
-            m_v2d = [v2n] (const QVariant &value)
-                { return QVariant(v2n(value)); };
-            m_d2v = [n2v] (const QVariant &sqlData)
-                { return n2v(sqlData.toString()); };
-            break;
-        }
-#define JSON_CASE(T) \
-        if (_Is<T>(type)) { \
-            m_sqlType = u"TEXT"_q; \
-            m_v2d = _ValueToSqlDataUsingJson<T>; \
-            m_d2v = _SqlDataToValueUsingJson<T>; \
-            break;\
-        }
-        JSON_CASE(VideoColor);
-        JSON_CASE(SubtitleStateInfo);
-        JSON_CASE(AudioEqualizer);
-        if (_Is<Mrl>(type)) {
-            m_sqlType = u"TEXT PRIMARY KEY NOT NULL"_q;
-            m_v2d = [] (const QVariant &value)
-                { return QVariant(value.value<Mrl>().toString()); };
-            m_d2v = [] (const QVariant &sqlData) {
-                if (sqlData.isNull() || !sqlData.isValid())
-                    return QVariant();
-                return QVariant::fromValue(Mrl::fromString(sqlData.toString()));
-            };
-            break;
-        }
-        Q_ASSERT(false);
-    }}
+    using Codec = SqlCodec<T>;
+    MrlStateFieldIO io;
+    io.name = name;
+    io.sqlType = Codec::type;
+    io.toSql = [] (const MrlState *s) { return Codec::toSql(s->*m); };
+    io.fromSql = [] (MrlState *s, const QVariant &data)
+        { return Codec::fromSql(s->*m, data); };
+    io.equals = [] (const MrlState *lhs, const MrlState *rhs)
+        { return lhs->*m == rhs->*m; };
+    io.copy = [] (MrlState *dest, const MrlState *src) { dest->*m = src->*m; };
+    io.reset = [] (MrlState *s) { s->*m = _MrlStateDefault().*m; };
+    return io;
+}
+
+#include "mrlstatefields.hpp"
+
+MrlStateSqlField::MrlStateSqlField(const MrlStateFieldIO *io) noexcept
+    : m_io(io)
+{
+    auto &mo = MrlState::staticMetaObject;
+    m_property = mo.property(mo.indexOfProperty(io->name));
+}
+
+auto MrlStateSqlField::list() -> QVector<MrlStateSqlField>
+{
+    QVector<MrlStateSqlField> list;
+    list.reserve(sizeof(MrlStateFields)/sizeof(MrlStateFields[0]));
+    for (auto &io : MrlStateFields)
+        list.push_back(&io);
+    return list;
 }
 
 /******************************************************************************/
@@ -117,18 +227,15 @@ auto MrlStateSqlFieldList::prepareInsert(const QString &table) -> QString
     const auto phs = _ToStringList(m_fields, [&] (const MrlStateSqlField &) {
         return QString('?'_q);
     }).join(','_q);
-    const auto cols = _ToStringList(m_fields, [&] (const MrlStateSqlField &f) {
-        return QString::fromLatin1(f.property().name());
-    }).join(','_q);
     insert = u"INSERT OR REPLACE INTO %1 (%2) VALUES (%3)"_q
-            .arg(table).arg(cols).arg(phs);
+            .arg(table).arg(names().join(','_q)).arg(phs);
     return insert;
 }
 
 auto MrlStateSqlFieldList::field(const QString &name) const -> Field
 {
     for (auto &field : m_fields) {
-        if (!name.compare(_L(field.property().name())))
+        if (name == field.name())
             return field;
     }
     return MrlStateSqlField();
@@ -142,41 +249,82 @@ auto MrlStateSqlFieldList::prepareSelect(const QString &table,
     if (m_fields.isEmpty() || !where.isValid())
         return QString();
     m_where = where;
-    const auto columns = _ToStringList(m_fields,
-                                       [&] (const MrlStateSqlField &field) {
-        return QString::fromLatin1(field.property().name());
-    }).join(','_q);
     select = u"SELECT %1 FROM %2 WHERE %3 = ?"_q
-            .arg(columns).arg(table).arg(_L(m_where.property().name()));
+            .arg(names().join(','_q)).arg(table).arg(m_where.name());
     return select;
 }
 
-auto MrlStateSqlFieldList::select(QSqlQuery &query, QObject *object,
-                                  const QVariant &where) const -> bool
+auto MrlStateSqlFieldList::select(QSqlQuery &query, MrlState *state,
+                                  const Mrl &mrl,
+                                  QVector<QVariant> *sqlData) const -> bool
 {
     auto &select = m_queries[Select];
     if (select.isEmpty())
         return false;
     if (!query.prepare(select))
         return false;
-    query.addBindValue(m_where.sqlData(where));
+    query.addBindValue(SqlCodec<Mrl>::toSql(mrl));
     if (!query.exec() || !query.next())
         return false;
-    const auto record = query.record();
+    if (sqlData)
+        sqlData->resize(m_fields.size());
     for (int i = 0; i < m_fields.size(); ++i) {
-        Q_ASSERT(_L(m_fields[i].property().name()) == record.fieldName(i));
-        m_fields[i].exportTo(object, record.value(i));
+        const auto value = query.value(i);
+        m_fields[i].exportTo(state, value);
+        if (sqlData)
+            (*sqlData)[i] = value;
     }
     return true;
 }
 
-auto MrlStateSqlFieldList::insert(QSqlQuery &query, const QObject *o) -> bool
+auto MrlStateSqlFieldList::sqlData(const MrlState *s) const -> QVector<QVariant>
+{
+    QVector<QVariant> values; values.reserve(m_fields.size());
+    for (auto &field : m_fields)
+        values.push_back(field.sqlData(s));
+    return values;
+}
+
+auto MrlStateSqlFieldList::sync(MrlState *base, QVector<QVariant> &sqlData,
+                                const MrlState *state) const -> int
+{
+    const bool all = sqlData.size() != m_fields.size();
+    if (all)
+        sqlData.resize(m_fields.size());
+    int changed = 0;
+    for (int i = 0; i < m_fields.size(); ++i) {
+        auto &field = m_fields[i];
+        if (!all && field.equals(base, state))
+            continue;
+        field.copy(base, state);
+        sqlData[i] = field.sqlData(state);
+        ++changed;
+    }
+    return changed;
+}
+
+auto MrlStateSqlFieldList::exportTo(MrlState *s,
+                                    const QVector<QVariant> &sqlData) const -> void
+{
+    Q_ASSERT(sqlData.size() == m_fields.size());
+    for (int i = 0; i < m_fields.size(); ++i)
+        m_fields[i].exportTo(s, sqlData[i]);
+}
+
+auto MrlStateSqlFieldList::names() const -> QStringList
+{
+    return _ToStringList(m_fields, [&] (const MrlStateSqlField &f) {
+        return QString(f.name());
+    });
+}
+
+auto MrlStateSqlFieldList::insert(QSqlQuery &query, const MrlState *s) -> bool
 {
     if (!isInsertPrepared())
         return false;
     if (!query.prepare(m_queries[Insert]))
         return false;
     for (int i=0; i<m_fields.size(); ++i)
-        query.bindValue(i, m_fields[i].sqlData(o));
+        query.bindValue(i, m_fields[i].sqlData(s));
     return query.exec();
 }
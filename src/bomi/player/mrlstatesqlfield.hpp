@@ -1,33 +1,39 @@
 #ifndef MRLSTATESQLFIELD_HPP
 #define MRLSTATESQLFIELD_HPP
 
-#include <functional>
+#include "mrlstate.hpp"
 
-struct MrlStateSqlField;
+// accessors of one column generated from prebuild/mrlstate-list
+struct MrlStateFieldIO {
+    const char *name = nullptr;
+    const char *sqlType = nullptr;
+    auto (*toSql)(const MrlState *state) -> QVariant = nullptr;
+    auto (*fromSql)(MrlState *state, const QVariant &data) -> bool = nullptr;
+    auto (*equals)(const MrlState *lhs, const MrlState *rhs) -> bool = nullptr;
+    auto (*copy)(MrlState *dest, const MrlState *src) -> void = nullptr;
+    auto (*reset)(MrlState *state) -> void = nullptr;
+};
 
 struct MrlStateSqlField {
     MrlStateSqlField() noexcept { }
-    MrlStateSqlField(const QMetaProperty &property,
-                     const QVariant &def = QVariant()) noexcept;
-    auto type() const -> QString { return m_sqlType; }
+    MrlStateSqlField(const MrlStateFieldIO *io) noexcept;
+    auto name() const -> QLatin1String { return QLatin1String(m_io->name); }
+    auto type() const -> QString { return _L(m_io->sqlType); }
     const QMetaProperty &property() const { return m_property; }
-    const QVariant &default_() const { return m_defaultValue; }
-    auto sqlData(const QObject *state) const noexcept -> QVariant
-        { return sqlData(m_property.read(state)); }
-    auto sqlData(const QVariant &value) const noexcept -> QVariant
-        { return m_v2d(value); }
-    auto exportTo(QObject *state, const QVariant &sqlData) const -> bool
-    {
-        const auto var = m_d2v(sqlData);
-        return m_property.write(state, var.isValid() ? var : m_defaultValue);
-    }
-    auto isValid() const -> bool { return m_v2d && m_d2v; }
+    auto sqlData(const MrlState *state) const -> QVariant
+        { return m_io->toSql(state); }
+    auto exportTo(MrlState *state, const QVariant &sqlData) const -> void
+        { if (!m_io->fromSql(state, sqlData)) m_io->reset(state); }
+    auto equals(const MrlState *lhs, const MrlState *rhs) const -> bool
+        { return m_io->equals(lhs, rhs); }
+    auto copy(MrlState *dest, const MrlState *src) const -> void
+        { m_io->copy(dest, src); }
+    auto isValid() const -> bool { return m_io != nullptr; }
+    // all fields in column order, mrl comes first
+    static auto list() -> QVector<MrlStateSqlField>;
 private:
-    using ConvertVariant = std::function<QVariant(QVariant)>;
+    const MrlStateFieldIO *m_io = nullptr;
     QMetaProperty m_property;
-    QString m_sqlType;
-    QVariant m_defaultValue;
-    ConvertVariant m_v2d = nullptr, m_d2v = nullptr;
 };
 
 class MrlStateSqlFieldList {
@@ -44,19 +50,25 @@ public:
     auto isEmpty() const -> bool { return m_fields.isEmpty(); }
     auto clear() -> void;
     auto reserve(int size) -> void { m_fields.reserve(size); }
-    auto push_back(const QMetaProperty &property, const QVariant &def) -> void
-        { m_fields.push_back({ property, def }); }
     auto push_back(const Field &field) -> void { m_fields.push_back(field); }
     auto prepareInsert(const QString &table) -> QString;
     auto prepareSelect(const QString &table, const Field &where) -> QString;
     auto field(const QString &name) const -> Field;
-    auto insert(QSqlQuery &query, const QObject *object) -> bool;
-    auto select(QSqlQuery &query, QObject *object) const -> bool
-        { return select(query, object, m_where.sqlData(object)); }
-    auto select(QSqlQuery &q, QObject *o, const QVariant &where) const -> bool;
-    template<class T>
-    auto select(QSqlQuery &query, QObject *object, const T &t) const -> bool
-        { return select(query, object, QVariant::fromValue<T>(t)); }
+    auto insert(QSqlQuery &query, const MrlState *state) -> bool;
+    // values of fields in order to bind later
+    auto sqlData(const MrlState *state) const -> QVector<QVariant>;
+    // copies fields of state which differ from base into base and encodes
+    // only them into sqlData which holds values of base. returns number of
+    // changed fields. sqlData is filled entirely if empty.
+    auto sync(MrlState *base, QVector<QVariant> &sqlData,
+              const MrlState *state) const -> int;
+    auto exportTo(MrlState *state, const QVector<QVariant> &sqlData) const -> void;
+    auto names() const -> QStringList;
+    auto select(QSqlQuery &query, MrlState *state) const -> bool
+        { return select(query, state, state->mrl); }
+    // sqlData receives values as read if not null
+    auto select(QSqlQuery &query, MrlState *state, const Mrl &mrl,
+                QVector<QVariant> *sqlData = nullptr) const -> bool;
     auto isInsertPrepared() const -> bool { return isPrepared(Insert); }
     auto isSelectPrepared() const -> bool { return isPrepared(Select); }
     auto isPrepared(QueryType type) const -> bool
@@ -3,6 +3,7 @@
 #include "opengl/openglframebufferobject.hpp"
 #include "audio/audionormalizeroption.hpp"
 #include "playengine_p.hpp"
+#include "misc/startuptimeline.hpp"
 
 PlayEngine::PlayEngine()
 : d(new Data(this)) {
@@ -35,12 +36,21 @@ PlayEngine::PlayEngine()
     mpv_request_log_messages(d->handle, loglv.constData());
 
     d->observe();
+    d->flusher.setSingleShot(true);
+    connect(&d->flusher, &QTimer::timeout, this, [=] () { d->flushUpdates(); });
+    d->timeNotifier.setSingleShot(true);
+    d->timeNotifier.setInterval(TimeNotifyInterval);
+    connect(&d->timeNotifier, &QTimer::timeout, this, [=] () { d->notifyTime(); });
+    connect(this, &PlayEngine::tick, this, [=] () {
+        if (!d->timeNotifier.isActive())
+            d->notifyTime();
+    });
     connect(d->filter, &VideoFilter::skippingChanged, this, [=] (bool skipping) {
         if (skipping) {
-            d->setmpv("mute", true);
+            d->setmpv_async("mute", true);
             d->pauseAfterSkip = isPaused();
-            d->setmpv("pause", false);
-            d->setmpv("speed", 100.0);
+            d->setmpv_async("pause", false);
+            d->setmpv_async("speed", 100.0);
         } else {
             d->setmpv_async("speed", d->speed);
             d->setmpv_async("pause", d->pauseAfterSkip);
@@ -132,20 +142,8 @@ PlayEngine::PlayEngine()
             }
         }
     }
-    d->fatal(mpv_initialize(d->handle), "Couldn't initialize mpv.");
-    _Debug("Initialized");
-    d->initialized = true;
-    d->hook();
-
-    auto ptr = mpv_get_sub_api(d->handle, MPV_SUB_API_OPENGL_CB);
-    d->glMpv = static_cast<mpv_opengl_cb_context*>(ptr);
-    Q_ASSERT(d->glMpv);
-    auto cbUpdate = [] (void *priv) {
-        auto p = static_cast<PlayEngine*>(priv);
-        if (p->d->video)
-            p->d->video->updateForNewFrame(p->d->videoInfo.renderer()->size());
-    };
-    mpv_opengl_cb_set_update_callback(d->glMpv, cbUpdate, this);
+    // mpv is initialized in playloop thread while main window is being built
+    d->thread.start();
 
     d->fpsMeasure.setTimer([=]()
         { d->videoInfo.renderer()->setFps(d->fpsMeasure.get()); }, 100000);
@@ -155,6 +153,8 @@ PlayEngine::~PlayEngine()
 {
     d->initialized = false;
     mpv_terminate_destroy(d->handle);
+    qDeleteAll(d->updates);
+    qDeleteAll(d->flushing);
     delete d->chapterInfo;
     delete d->audio;
     delete d->video;
@@ -173,10 +173,17 @@ auto PlayEngine::initializeGL(QOpenGLContext *ctx) -> void
     };
     auto err = mpv_opengl_cb_init_gl(d->glMpv, nullptr, getProcAddr, ctx);
     Q_ASSERT(err >= 0);
+    QMutexLocker locker(&d->glMutex);
+    d->glInitialized = true;
+    if (_Change(d->glWaiting, false))
+        d->tellmpv_async("hook_ack", "on_preloaded"_b);
 }
 
 auto PlayEngine::finalizeGL(QOpenGLContext */*ctx*/) -> void
 {
+    d->glMutex.lock();
+    d->glInitialized = false;
+    d->glMutex.unlock();
     mpv_opengl_cb_uninit_gl(d->glMpv);
 }
 
@@ -188,7 +195,7 @@ auto PlayEngine::metaData() const -> const MetaData&
 auto PlayEngine::setSubtitleDelay(int ms) -> void
 {
     if (_Change(d->subDelay, ms))
-        d->setmpv_async("sub-delay", d->subDelay/1000.0);
+        d->setmpv_latest("sub-delay", d->subDelay/1000.0);
 }
 
 auto PlayEngine::setSubtitleFiles(const StreamList &files) -> void
@@ -283,7 +290,8 @@ auto PlayEngine::audioStreams() const -> const StreamList&
 
 auto PlayEngine::run() -> void
 {
-    d->thread.start();
+    d->ready.acquire();
+    d->initialized = true;
 }
 
 auto PlayEngine::thread() const -> QThread*
@@ -316,7 +324,7 @@ SIA _ChangeZ(double &the, double one) -> bool
 auto PlayEngine::setSpeed(double speed) -> void
 {
     if (_ChangeZ(d->speed, speed)) {
-        d->setmpv_async("speed", speed);
+        d->setmpv_latest("speed", speed);
         emit speedChanged(d->speed);
     }
 }
@@ -329,15 +337,37 @@ auto PlayEngine::setSubtitleStyle(const OsdStyle &style) -> void
 auto PlayEngine::seek(int pos) -> void
 {
     d->chapter = -1;
-    if (!d->hasImage)
-        d->tellmpv("seek", (double)pos/1000.0, 2);
+    if (!d->hasImage) {
+        if (d->scrubbing)
+            d->scrub(pos);
+        else
+            d->tellmpv_latest("seek", (double)pos/1000.0, 2);
+    }
     d->filter->stopSkipping();
 }
 
+auto PlayEngine::setScrubbing(bool scrubbing) -> void
+{
+    if (!_Change(d->scrubbing, scrubbing))
+        return;
+    if (!scrubbing && d->scrubTarget >= 0) {
+        // replaces keyframe seek if it is still waiting
+        const auto target = QByteArray::number(d->scrubTarget/1000.0);
+        d->command("seek"_b, {"seek"_b, target, "absolute"_b, "exact"_b}, nullptr);
+    }
+    d->scrubTarget = d->scrubSent = -1;
+    emit scrubbingChanged(scrubbing);
+}
+
+auto PlayEngine::isScrubbing() const -> bool
+{
+    return d->scrubbing;
+}
+
 auto PlayEngine::relativeSeek(int pos) -> void
 {
     if (!d->hasImage) {
-        d->tellmpv("seek", (double)pos/1000.0, 0);
+        d->tellmpv_async("seek", (double)pos/1000.0, 0);
         emit sought();
     }
     d->filter->stopSkipping();
@@ -367,8 +397,8 @@ auto PlayEngine::reload() -> void
 auto PlayEngine::setChannelLayout(ChannelLayout layout) -> void
 {
     if (_Change(d->layout, layout) && d->position > 0) {
-        d->setmpv("options/audio-channels", ChannelLayoutInfo::data(d->layout));
-        d->tellmpv("ao_reload");
+        d->setmpv_async("options/audio-channels", ChannelLayoutInfo::data(d->layout));
+        d->tellmpv_async("ao_reload");
     }
 }
 
@@ -438,10 +468,11 @@ auto PlayEngine::addSubtitleStream(const QString &fileName,
         file.path = info.absoluteFilePath();
         file.encoding = enc;
         d->subtitleFiles.append(file);
-        d->setmpv("options/subcp", enc.toLatin1().constData());
-        d->tellmpv("sub_add", file.path);
-        if (d->subStreamsVisible)
-            d->setmpv_async("sub-visibility", true);
+        d->setmpv_async("options/subcp", enc.toLatin1());
+        d->tellmpv_async("sub_add"_b, {file.path.toLocal8Bit()}, [=] (int error) {
+            if (d->isSuccess(error) && d->subStreamsVisible)
+                d->setmpv_async("sub-visibility", true);
+        });
         return true;
     }
     return false;
@@ -458,7 +489,7 @@ auto PlayEngine::removeSubtitleStream(int id) -> void
                     d->subtitleFiles.removeAt(i);
             }
         }
-        d->tellmpv("sub_remove", id);
+        d->tellmpv_async("sub_remove", id);
     }
 }
 
@@ -474,8 +505,15 @@ auto PlayEngine::setNextStartInfo(const StartInfo &startInfo) -> void
 
 auto PlayEngine::stepFrame(int direction) -> void
 {
-    if ((d->state & (Playing | Paused)) && d->seekable)
-        d->tellmpv_async(direction > 0 ? "frame_step" : "frame_back_step");
+    if (!(d->state & (Playing | Paused)) || !d->seekable)
+        return;
+    if (direction > 0)
+        d->tellmpv_async("frame_step");
+    else {
+        // frame_back_step decodes whole GOP again unless filter has it
+        d->filter->prepareBackstep(d->position);
+        d->tellmpv_async("frame_back_step");
+    }
 }
 
 auto PlayEngine::isWaiting() const -> bool
@@ -537,7 +575,7 @@ auto PlayEngine::setCurrentEdition(int id, int from) -> void
         d->check(mpv_command_async(d->handle, 0, cmds),
                  "Couldn't send 'discnav menu'.");
     } else if (0 <= id && id < d->editions.size()) {
-        d->setmpv(mrl.isDisc() ? "disc-title" : "edition", id);
+        d->setmpv_async(mrl.isDisc() ? "disc-title" : "edition", id);
         seek(from);
     }
 }
@@ -545,7 +583,7 @@ auto PlayEngine::setCurrentEdition(int id, int from) -> void
 auto PlayEngine::setVolume(int volume) -> void
 {
     if (_Change(d->volume, qBound(0, volume, 100))) {
-        d->setmpv_async("volume", d->mpVolume());
+        d->setmpv_latest("volume", d->mpVolume());
         emit volumeChanged(d->volume);
     }
 }
@@ -568,7 +606,7 @@ auto PlayEngine::amp() const -> double
 auto PlayEngine::setAmp(double amp) -> void
 {
     if (_ChangeZ(d->amp, qBound(0.0, amp, 10.0))) {
-        d->setmpv_async("volume", d->mpVolume());
+        d->setmpv_latest("volume", d->mpVolume());
         emit preampChanged(d->amp);
     }
 }
@@ -583,10 +621,30 @@ auto PlayEngine::setMuted(bool muted) -> void
 
 auto PlayEngine::exec() -> void
 {
+    d->fatal(mpv_initialize(d->handle), "Couldn't initialize mpv.");
+    _Debug("Initialized");
+    d->hook();
+
+    auto ptr = mpv_get_sub_api(d->handle, MPV_SUB_API_OPENGL_CB);
+    d->glMpv = static_cast<mpv_opengl_cb_context*>(ptr);
+    Q_ASSERT(d->glMpv);
+    auto cbUpdate = [] (void *priv) {
+        auto p = static_cast<PlayEngine*>(priv);
+        if (p->d->video && p->d->videoVisible)
+            p->d->video->updateForNewFrame(p->d->videoInfo.renderer()->size());
+    };
+    mpv_opengl_cb_set_update_callback(d->glMpv, cbUpdate, this);
+    StartupTimeline::mark("mpv initialized");
+    d->ready.release();
+
     _Debug("Start playloop thread");
     d->quit = false;
-    while (!d->quit)
-        d->dispatch(mpv_wait_event(d->handle, 0.005));
+    // block until mpv has something to tell; polling would keep waking up
+    // while paused
+    while (!d->quit) {
+        d->dispatch(mpv_wait_event(d->handle, -1));
+        ++d->wakeups;
+    }
     _Debug("Finish playloop thread");
 }
 
@@ -635,7 +693,7 @@ auto PlayEngine::pause() -> void
     if (d->hasImage)
         d->post(Paused);
     else
-        d->setmpv("pause", true);
+        d->setmpv_async("pause", true);
     d->pauseAfterSkip = true;
     d->filter->stopSkipping();
 }
@@ -645,7 +703,7 @@ auto PlayEngine::unpause() -> void
     if (d->hasImage)
         d->post(Playing);
     else
-        d->setmpv("pause", false);
+        d->setmpv_async("pause", false);
 }
 
 auto PlayEngine::mrl() const -> Mrl
@@ -681,7 +739,7 @@ auto PlayEngine::setCurrentAudioStream(int id, bool reserve) -> void
 auto PlayEngine::setAudioSync(int sync) -> void
 {
     if (_Change(d->audioSync, sync))
-        d->setmpv_async("audio-delay", sync*0.001);
+        d->setmpv_latest("audio-delay", sync*0.001);
 }
 
 auto PlayEngine::setVolumeNormalizerActivated(bool on) -> void
@@ -695,7 +753,7 @@ auto PlayEngine::setVolumeNormalizerActivated(bool on) -> void
 auto PlayEngine::setTempoScalerActivated(bool on) -> void
 {
     if (_Change(d->tempoScaler, on)) {
-        d->tellmpv("af", "set"_b, d->af());
+        d->tellmpv_async("af", "set"_b, d->af());
         emit tempoScaledChanged(on);
     }
 }
@@ -712,7 +770,8 @@ auto PlayEngine::isTempoScaled() const -> bool
 
 auto PlayEngine::stop() -> void
 {
-    d->tellmpv("stop");
+    d->dropWaiting();
+    d->tellmpv_async("stop");
 }
 
 auto PlayEngine::setVolumeNormalizerOption(const AudioNormalizerOption &option)
@@ -743,8 +802,8 @@ auto PlayEngine::setDeintMode(DeintMode mode) -> void
 {
     if (_Change(d->deint, mode)) {
         if (isPaused()) {
-            d->setmpv("deinterlace", !!(int)mode);
-            d->refresh();
+            d->setmpv_async("deinterlace", !!(int)mode,
+                            [=] (int) { d->refresh(); });
         } else
             d->setmpv_async("deinterlace", !!(int)mode);
     }
@@ -780,10 +839,9 @@ auto PlayEngine::subtitleFiles() const -> QVector<SubtitleFileInfo>
 
 auto PlayEngine::audioDeviceList() const -> QList<AudioDevice>
 {
-    const QVariantList list = d->getmpv<QVariant>("audio-device-list").toList();
     QList<AudioDevice> devs;
-    devs.reserve(list.size());
-    for (auto &one : list) {
+    devs.reserve(d->audioDevices.size());
+    for (auto &one : d->audioDevices) {
         const auto map = one.toMap();
         AudioDevice dev;
         dev.name = map[u"name"_q].toString();
@@ -899,6 +957,22 @@ auto PlayEngine::setHighQualityScaling(bool up, bool down) -> void
     }
 }
 
+auto PlayEngine::setAdaptiveDecoding(bool on) -> void
+{
+    if (_Change(d->adaptiveDecoding, on) && !on) {
+        const bool degraded = d->decoderQuality.level() > 0;
+        d->decoderQuality.reset();
+        if (degraded)
+            d->applyDecoderQuality();
+    }
+}
+
+auto PlayEngine::setVideoVisible(bool visible) -> void
+{
+    if (d->videoVisible.exchange(visible) != visible && visible && d->video)
+        d->video->updateForNewFrame(d->displaySize());
+}
+
 auto PlayEngine::seekToNextBlackFrame() -> void
 {
     if (!isStopped())
@@ -52,7 +52,7 @@ class PlayEngine : public QObject {
     Q_PROPERTY(int begin READ begin NOTIFY beginChanged)
     Q_PROPERTY(int end READ end NOTIFY endChanged)
     Q_PROPERTY(int duration READ duration NOTIFY durationChanged)
-    Q_PROPERTY(int time READ time WRITE seek NOTIFY tick)
+    Q_PROPERTY(int time READ time WRITE seek NOTIFY timeChanged)
     Q_PROPERTY(int volume READ volume WRITE setVolume NOTIFY volumeChanged)
     Q_PROPERTY(int cacheSize READ cacheSize NOTIFY cacheSizeChanged)
     Q_PROPERTY(int cacheUsed READ cacheUsed NOTIFY cacheUsedChanged)
@@ -66,9 +66,10 @@ class PlayEngine : public QObject {
     Q_PROPERTY(bool stopped READ isStopped NOTIFY stoppedChanged)
     Q_PROPERTY(double speed READ speed NOTIFY speedChanged)
     Q_PROPERTY(bool volumeNormalizerActivated READ isVolumeNormalizerActivated NOTIFY volumeNormalizerActivatedChanged)
-    Q_PROPERTY(double rate READ rate WRITE setRate NOTIFY tick)
+    Q_PROPERTY(double rate READ rate WRITE setRate NOTIFY timeChanged)
     Q_PROPERTY(QQuickItem *screen READ screen)
     Q_PROPERTY(bool hasVideo READ hasVideo NOTIFY hasVideoChanged)
+    Q_PROPERTY(bool scrubbing READ isScrubbing WRITE setScrubbing NOTIFY scrubbingChanged)
     Q_PROPERTY(ChapterInfoObject *chapter READ chapterInfo NOTIFY chaptersChanged)
     Q_PROPERTY(SubtitleInfoObject* subtitle READ subInfo NOTIFY subInfoChanged)
     Q_PROPERTY(QString stateText READ stateText NOTIFY stateChanged)
@@ -210,6 +211,13 @@ public:
     auto snapshot(bool withOsd = true) -> QImage;
     auto clearSnapshots() -> void;
     auto setHighQualityScaling(bool up, bool down) -> void;
+    auto setAdaptiveDecoding(bool on) -> void;
+    // no frame is rendered while invisible, e.g., minimized
+    auto setVideoVisible(bool visible) -> void;
+    // while scrubbing, seek goes to nearest keyframe and one exact seek
+    // follows when scrubbing ends
+    auto setScrubbing(bool scrubbing) -> void;
+    auto isScrubbing() const -> bool;
     auto waitingText() const -> QString;
     auto stateText() const -> QString;
 public slots:
@@ -218,11 +226,13 @@ signals:
     void subInfoChanged();
     void seeked(int time);
     void sought();
+    void scrubbingChanged(bool scrubbing);
     void tempoScaledChanged(bool on);
     void volumeNormalizerActivatedChanged(bool on);
     void started(Mrl mrl, bool reloaded);
     void finished(const FinishInfo &info);
     void tick(int pos);
+    void timeChanged(); // throttled tick for QML
     void mrlChanged(const Mrl &mrl);
     void stateChanged(PlayEngine::State state);
     void seekableChanged(bool seekable);
@@ -1,4 +1,7 @@
 #include "playengine_p.hpp"
+#include "opengl/opengltexturepool.hpp"
+#include "misc/tracerecorder.hpp"
+#include "misc/startuptimeline.hpp"
 
 template<class T>
 SIA findEnum(const QString &mpv) -> T
@@ -90,6 +93,28 @@ auto PlayEngine::Data::vo() const -> QByteArray
             + videoSubOptions();
 }
 
+// linked programs of mpv's renderer are cached here by their binaries
+static auto shaderCacheDir() -> QByteArray
+{
+    static QByteArray escaped;
+    if (escaped.isEmpty()) {
+        const auto path = _WritablePath(Location::Config) % "/shader-cache"_a;
+        QDir dir(path);
+        if (!dir.exists() && !dir.mkpath(path))
+            return QByteArray();
+        // each colour adjustment is a new program; keep recently used ones
+        // only (mpv touches an entry whenever it is loaded)
+        constexpr int MaxEntries = 256;
+        const auto files = dir.entryInfoList({ u"*.bin"_q }, QDir::Files,
+                                             QDir::Time);
+        for (int i = MaxEntries; i < files.size(); ++i)
+            QFile::remove(files[i].absoluteFilePath());
+        const auto local = path.toLocal8Bit();
+        escaped = '%' + QByteArray::number(local.length()) + '%' + local;
+    }
+    return escaped;
+}
+
 auto PlayEngine::Data::videoSubOptions() const -> QByteArray
 {
     static const QByteArray shader =
@@ -147,6 +172,9 @@ auto PlayEngine::Data::videoSubOptions() const -> QByteArray
     opts.add("fancy-downscaling", hqDownscaling);
     opts.add("sigmoid-upscaling", hqUpscaling);
     opts.add("custom-shader", customShader(c_matrix));
+    const auto cacheDir = shaderCacheDir();
+    if (!cacheDir.isEmpty())
+        opts.add("shader-cache-dir", cacheDir);
 
     return opts.get();
 }
@@ -179,23 +207,118 @@ auto PlayEngine::Data::updateVideoSubOptions() -> void
     tellmpv_async("vo_cmdline", videoSubOptions());
 }
 
-auto PlayEngine::Data::tellmpv(const QByteArray &cmd) -> void
+auto PlayEngine::Data::request(AsyncRequest &&req) -> void
 {
-    if (handle)
-        check(mpv_command_string(handle, cmd.constData()),
-              "Cannaot execute: %%", cmd);
+    if (!handle)
+        return;
+    QMutexLocker locker(&asyncMutex);
+    if (!req.key.isEmpty() && asyncFlying.contains(req.key)) {
+        req.order = ++asyncOrder;
+        asyncWaiting[req.key] = std::move(req);
+        return;
+    }
+    // waiting ones have been issued earlier and should not be overtaken
+    sendWaiting(asyncOrder);
+    send(std::move(req));
 }
 
-auto PlayEngine::Data::tellmpv_async(const QByteArray &cmd,
-                   std::initializer_list<QByteArray> &&list) -> void
+auto PlayEngine::Data::send(AsyncRequest &&req) -> void
+{
+    const auto id = ++asyncId;
+    if (!req.key.isEmpty())
+        ++asyncFlying[req.key];
+    auto &sent = asyncSent[id];
+    sent = std::move(req);
+    const int error = sent.send(id);
+    if (!isSuccess(error))
+        _PostEvent(p, AsyncReply, id, error);
+}
+
+auto PlayEngine::Data::sendWaiting(quint64 order) -> void
+{
+    QVector<AsyncRequest> queue;
+    for (auto it = asyncWaiting.begin(); it != asyncWaiting.end(); ) {
+        if (it->order <= order) {
+            queue.push_back(std::move(*it));
+            it = asyncWaiting.erase(it);
+        } else
+            ++it;
+    }
+    std::sort(queue.begin(), queue.end(),
+              [] (const AsyncRequest &lhs, const AsyncRequest &rhs)
+              { return lhs.order < rhs.order; });
+    for (auto &req : queue)
+        send(std::move(req));
+}
+
+auto PlayEngine::Data::dropWaiting() -> void
+{
+    QMutexLocker locker(&asyncMutex);
+    asyncWaiting.clear();
+}
+
+auto PlayEngine::Data::reply(quint64 id, int error) -> void
+{
+    asyncMutex.lock();
+    auto req = asyncSent.take(id);
+    if (!req.key.isEmpty()) {
+        auto it = asyncFlying.find(req.key);
+        Q_ASSERT(it != asyncFlying.end());
+        if (!--*it) {
+            asyncFlying.erase(it);
+            // the latest one goes with others issued before it
+            const auto waiting = asyncWaiting.constFind(req.key);
+            if (waiting != asyncWaiting.cend())
+                sendWaiting(waiting->order);
+        }
+    }
+    asyncMutex.unlock();
+    if (!isSuccess(error))
+        _Debug("Error %%: Couldn't execute %%.", this->error(error), req.desc);
+    if (req.done)
+        req.done(error);
+}
+
+auto PlayEngine::Data::command(const QByteArray &key, QList<QByteArray> &&args,
+                               AsyncDone &&done) -> void
+{
+    AsyncRequest req;
+    req.key = key;
+    for (auto &arg : args)
+        req.desc += arg + ' ';
+    req.desc.chop(1);
+    req.done = std::move(done);
+    req.send = [this, args] (quint64 id) {
+        QVector<const char*> argv(args.size() + 1, nullptr);
+        for (int i = 0; i < args.size(); ++i)
+            argv[i] = args[i].constData();
+        return mpv_command_async(handle, id, argv.data());
+    };
+    request(std::move(req));
+}
+
+auto PlayEngine::Data::scrub(int pos) -> void
+{
+    scrubTarget = pos;
+    if (!scrubSeeking)
+        scrubNext();
+}
+
+auto PlayEngine::Data::scrubNext() -> void
+{
+    scrubSeeking = true;
+    scrubSent = scrubTarget;
+    const auto target = QByteArray::number(scrubTarget/1000.0);
+    command("seek"_b, {"seek"_b, target, "absolute"_b, "keyframes"_b},
+            [=] (int error) { if (!isSuccess(error)) scrubSeeking = false; });
+}
+
+auto PlayEngine::Data::tellmpv(const QByteArray &cmd) -> void
 {
-    QVector<const char*> args(list.size()+2, nullptr);
-    auto it = args.begin();
-    *it++ = cmd.constData();
-    for (auto &one : list)
-        *it++ = one.constData();
     if (handle)
-        check(mpv_command_async(handle, 0, args.data()), "Cannot execute: %%", cmd);
+        check(blocking(cmd, [&] () {
+            return mpv_command_string(handle, cmd.constData());
+        }), "Cannaot execute: %%", cmd);
 }
 
 auto PlayEngine::Data::tellmpv(const QByteArray &cmd,
@@ -207,7 +330,8 @@ auto PlayEngine::Data::tellmpv(const QByteArray &cmd,
     for (auto &one : list)
         *it++ = one.constData();
     if (handle)
-        check(mpv_command(handle, args.data()), "Cannot execute: %%", cmd);
+        check(blocking(cmd, [&] () { return mpv_command(handle, args.data()); }),
+              "Cannot execute: %%", cmd);
 }
 
 auto PlayEngine::Data::loadfile(const Mrl &mrl, int resume, int cache,
@@ -290,7 +414,8 @@ auto PlayEngine::Data::loadfile(const Mrl &mrl, int resume, int cache,
     opts.add("colormatrix-input-range", _EnumData(colorRange).option);
     opts.add("vo"_b, vo(), true);
     _Debug("Load: %% (%%)", file, opts.get());
-    tellmpv("loadfile"_b, file.toLocal8Bit(), "replace"_b, opts.get());
+    dropWaiting();
+    tellmpv_async("loadfile"_b, file.toLocal8Bit(), "replace"_b, opts.get());
 }
 
 auto PlayEngine::Data::updateMrl() -> void
@@ -347,7 +472,7 @@ auto PlayEngine::Data::setStreamList(StreamType type, StreamList &&list) -> bool
     if (id >= 0) {
         for (auto &str : list)
             str.m_selected = str.m_id == id;
-        setmpv(info.mpvName, id);
+        setmpv_async(info.mpvName, id);
     }
     data.reserved = -1;
     if (streams[type].tracks == list)
@@ -363,11 +488,11 @@ auto PlayEngine::Data::hook() -> void
     hook("on_load", [=] () {
         auto file = getmpv<QString>("stream-open-filename");
         if (!file.startsWith("http://"_a) && !file.startsWith("https://"_a))
-            return;
+            return true;
         file = QUrl(file).toString(QUrl::FullyEncoded);
         if (yle && yle->supports(file)) {
             if (!yle->run(file))
-                return;
+                return true;
             setmpv("stream-open-filename", yle->url().toLocal8Bit());
         } else if (youtube && youtube->run(file)) {
             setmpv("options/cookies", true);
@@ -376,34 +501,48 @@ auto PlayEngine::Data::hook() -> void
             setmpv("stream-open-filename", youtube->url().toLocal8Bit());
         } else
             setmpv("stream-open-filename", file.toLocal8Bit());
+        return true;
+    });
+    // file can be opened before scene graph is initialized, but decoders
+    // and outputs need GL context. initializeGL() acknowledges it then.
+    hook("on_preloaded", [=] () {
+        StartupTimeline::mark("file preloaded");
+        QMutexLocker locker(&glMutex);
+        glWaiting = !glInitialized;
+        return !glWaiting;
     });
 }
 
 auto PlayEngine::Data::observe() -> void
 {
-    observeType<bool>("pause", [=] (bool p) {
-        if (p)
-            post(Paused);
-        else if (!getmpv<bool>("idle"))
-            post(Playing);
+    // idle is read on event thread not to block GUI thread
+    observe<bool>("pause", [=] (const mpv_event_property *ev) {
+        if (cast<bool>(ev))
+            return int(Paused);
+        return getmpv<bool>("idle") ? 0 : int(Playing);
+    }, [=] (QEvent *event) {
+        if (const auto state = _GetData<int>(event))
+            post(static_cast<State>(state));
     });
+    observeType<QVariant>("audio-device-list", [=] (QVariant &&list)
+        { audioDevices = list.toList(); });
     observeType<bool>("core-idle", [=] (bool i) { if (!i) post(Playing); });
     observeType<bool>("paused-for-cache", [=] (bool b) { post(Buffering, b); });
     observeType<bool>("seeking", [=] (bool s) { post(Seeking, s); });
 
-    observe("cache-used", cacheUsed, [=] () {
-        return cacheEnabled ? getmpv<int>("cache-used") : 0;
-    }, &PlayEngine::cacheUsedChanged);
-    observe("cache-size", cacheSize, [=] () {
-        return cacheEnabled ? getmpv<int>("cache-size") : 0;
-    }, &PlayEngine::cacheSizeChanged);
-    observeTime("time-pos", position, &PlayEngine::tick);
+    coalesce(observe<int>("cache-used", cacheUsed, [=] (const mpv_event_property *ev) {
+        return cacheEnabled ? cast<int>(ev) : 0;
+    }, &PlayEngine::cacheUsedChanged));
+    coalesce(observe<int>("cache-size", cacheSize, [=] (const mpv_event_property *ev) {
+        return cacheEnabled ? cast<int>(ev) : 0;
+    }, &PlayEngine::cacheSizeChanged));
+    coalesce(observeTime("time-pos", position, &PlayEngine::tick));
     observeTime("time-start", begin, &PlayEngine::beginChanged);
     observeTime("length", duration, &PlayEngine::durationChanged);
-    observeTime("avsync", avSync, &PlayEngine::avSyncChanged);
+    coalesce(observeTime("avsync", avSync, &PlayEngine::avSyncChanged));
     observe("seekable", seekable, &PlayEngine::seekableChanged);
-    observe("chapter-list", chapters, [=] () {
-        const auto array = getmpv<QVariant>("chapter-list").toList();
+    observeAs<QVariant>("chapter-list", chapters, [=] (const mpv_event_property *ev) {
+        const auto array = cast<QVariant>(ev).toList();
         ChapterList chapters; chapters.resize(array.size());
         for (int i=0; i<array.size(); ++i) {
             const auto map = array[i].toMap();
@@ -420,9 +559,9 @@ auto PlayEngine::Data::observe() -> void
         emit p->chaptersChanged(chapters);
     });
     observe("chapter", chapter, &PlayEngine::currentChapterChanged);
-    observe("track-list", [=] () {
+    observe<QVariant>("track-list", [=] (const mpv_event_property *ev) {
         QVector<StreamList> streams(3);
-        auto list = getmpv<QVariant>("track-list").toList();
+        auto list = cast<QVariant>(ev).toList();
         for (auto &var : list) {
             const auto track = StreamTrack::fromMpvData(var);
             streams[track.type()].insert(track.id(), track);
@@ -435,8 +574,8 @@ auto PlayEngine::Data::observe() -> void
     });
     for (auto type : streamTypes)
         observeTrack(type);
-    observe("metadata", metaData, [=] () {
-        const auto list = getmpv<QVariant>("metadata").toList();
+    observe<QVariant>("metadata", metaData, [=] (const mpv_event_property *ev) {
+        const auto list = cast<QVariant>(ev).toList();
         MetaData metaData;
         for (int i=0; i+1<list.size(); i+=2) {
             const auto key = list[i].toString();
@@ -494,12 +633,21 @@ auto PlayEngine::Data::observe() -> void
                          p[u"average-bpp"_q].toInt());
         info->setDepth(p[u"plane-depth"_q].toInt());
     };
-    observeType<QVariant>("video-params", [=] (QVariant &&var) {
-        const auto params = var.toMap();
+    // decoder details are read on event thread not to block GUI thread
+    struct VideoParams { QVariantMap params; QString range, space, hwdec; };
+    coalesce(observe<QVariant>("video-params", [=] (const mpv_event_property *ev) {
+        VideoParams vp;
+        vp.params = cast<QVariant>(ev).toMap();
+        vp.range = decoderOutput("colormatrix-input-range");
+        vp.space = decoderOutput("colormatrix");
+        vp.hwdec = getmpv<QString>("hwdec");
+        return vp;
+    }, [=] (QEvent *event) {
+        const auto vp = _MoveData<VideoParams>(event);
         auto info = videoInfo.output();
-        setParams(info, params, u"w"_q, u"h"_q);
-        info->setRange(findEnum<ColorRange>(decoderOutput("colormatrix-input-range")));
-        info->setSpace(findEnum<ColorSpace>(decoderOutput("colormatrix")));
+        setParams(info, vp.params, u"w"_q, u"h"_q);
+        info->setRange(findEnum<ColorRange>(vp.range));
+        info->setSpace(findEnum<ColorSpace>(vp.space));
         auto hwState = [&] () {
             if (!useHwAcc)
                 return Deactivated;
@@ -515,16 +663,15 @@ auto PlayEngine::Data::observe() -> void
         };
         auto hwacc = videoInfo.hwacc();
         hwacc->setState(hwState());
-        const auto hwdec = getmpv<QString>("hwdec");
-        hwacc->setDriver(hwdec == "no"_a ? QString() : hwdec);
-    });
-    observeType<QVariant>("video-out-params", [=] (QVariant &&var) {
+        hwacc->setDriver(vp.hwdec == "no"_a ? QString() : vp.hwdec);
+    }));
+    coalesce(observeType<QVariant>("video-out-params", [=] (QVariant &&var) {
         const auto params = var.toMap();
         auto info = videoInfo.renderer();
         setParams(info, params, u"dw"_q, u"dh"_q);
         info->setRange(findEnum<ColorRange>(params[u"colorlevels"_q].toString()));
         info->setSpace(findEnum<ColorSpace>(params[u"colormatrix"_q].toString()));
-    });
+    }));
 
     observeType<QString>("audio-codec", [=] (QString &&c) { audioInfo.codec()->parse(c); });
     observeType<QString>("audio-format", [=] (QString &&f) { audioInfo.input()->setType(f); });
@@ -536,38 +683,67 @@ auto PlayEngine::Data::observe() -> void
 
     for (const auto &ob : observations) {
         if (ob.name)
-            mpv_observe_property(handle, ob.event, ob.name, MPV_FORMAT_NONE);
+            mpv_observe_property(handle, ob.event, ob.name, ob.format);
+    }
+    updates.fill(nullptr, observations.size());
+    flushing.fill(nullptr, observations.size());
+    if (auto screen = QGuiApplication::primaryScreen())
+        flushInterval = qBound(4, qRound(1000.0/screen->refreshRate()), 50);
+    flushed.start();
+}
+
+auto PlayEngine::Data::requestFlush() -> void
+{
+    if (flusher.isActive())
+        return;
+    const int wait = flushInterval - flushed.elapsed();
+    if (wait > 0)
+        flusher.start(wait);
+    else
+        flushUpdates();
+}
+
+auto PlayEngine::Data::flushUpdates() -> void
+{
+    flusher.stop();
+    updateMutex.lock();
+    updates.swap(flushing);
+    flushPosted = false;
+    updateMutex.unlock();
+    flushed.restart();
+    for (auto &event : flushing) {
+        if (event) {
+            observation(event->type()).handle(event);
+            delete event;
+            event = nullptr;
+        }
+    }
+}
+
+auto PlayEngine::Data::notifyTime() -> void
+{
+    if (_Change(notifiedTime, position)) {
+        emit p->timeChanged();
+        timeNotifier.start();
     }
 }
 
 auto PlayEngine::Data::dispatch(mpv_event *event) -> void
 {
+    _TraceScope("PlayEngine::dispatch");
     switch (event->event_id) {
-    case MPV_EVENT_LOG_MESSAGE: {
-        thread_local QMap<QByteArray, QByteArray> leftmsg;
-        auto message = static_cast<mpv_event_log_message*>(event->data);
-        const QByteArray prefix(message->prefix);
-        auto &left = leftmsg[prefix];
-        left.append(message->text);
-        int from = 0;
-        for (;;) {
-            auto to = left.indexOf('\n', from);
-            if (to < 0)
-                break;
-            log(prefix, left.mid(from, to-from));
-            from = to + 1;
-        }
-        left = left.mid(from);
+    case MPV_EVENT_LOG_MESSAGE:
+        log(static_cast<mpv_event_log_message*>(event->data));
         break;
-    } case MPV_EVENT_CLIENT_MESSAGE: {
+    case MPV_EVENT_CLIENT_MESSAGE: {
         auto message = static_cast<mpv_event_client_message*>(event->data);
         if (message->num_args < 1)
             break;
         if (message->args[0] == "hook_run"_b && message->num_args == 3) {
             QByteArray when(message->args[2]);
             Q_ASSERT(hooks.contains(when));
-            hooks[when]();
-            tellmpv("hook_ack", when);
+            if (hooks[when]())
+                tellmpv("hook_ack", when);
         }
         break;
     } case MPV_EVENT_IDLE:
@@ -621,20 +797,15 @@ auto PlayEngine::Data::dispatch(mpv_event *event) -> void
         _PostEvent(p, EndPlayback, mpvMrl, reason);
         break;
     } case MPV_EVENT_PROPERTY_CHANGE:
-        observation(event->reply_userdata).post();
+        observation(event->reply_userdata).post(
+                    static_cast<mpv_event_property*>(event->data));
         break;
+    case MPV_EVENT_COMMAND_REPLY:
     case MPV_EVENT_SET_PROPERTY_REPLY:
-        if (!isSuccess(event->error)) {
-            auto ptr = reinterpret_cast<void*>(event->reply_userdata);
-            auto data = static_cast<QByteArray*>(ptr);
-            _Debug("Error %%: Couldn't set property %%.",
-                   mpv_error_string(event->error), *data);
-            delete data;
-        }
-        break;
-    case MPV_EVENT_GET_PROPERTY_REPLY: {
+        if (event->reply_userdata)
+            _PostEvent(p, AsyncReply, event->reply_userdata, event->error);
         break;
-    } case MPV_EVENT_SHUTDOWN:
+    case MPV_EVENT_SHUTDOWN:
         quit = true;
         break;
     case MPV_EVENT_PLAYBACK_RESTART:
@@ -649,12 +820,24 @@ auto PlayEngine::Data::dispatch(mpv_event *event) -> void
 auto PlayEngine::Data::process(QEvent *event) -> void
 {
     const int type = event->type();
+    if (type == FlushUpdates) {
+        requestFlush();
+        return;
+    }
+    // keep pending changes in order with other events and changes which
+    // are not coalesced. coalesced ones come only through flushUpdates().
+    flushUpdates();
     if (UpdateEventBegin <= type && type < updateEventMax) {
-        observation(event->type()).handle(event);
+        observation(type).handle(event);
         return;
     }
     switch ((int)event->type()) {
-     case StateChange:
+     case AsyncReply: {
+        quint64 id = 0; int error = 0;
+        _TakeData(event, id, error);
+        reply(id, error);
+        break;
+    } case StateChange:
         updateState(_GetData<PlayEngine::State>(event));
         break;
     case WaitingChange: {
@@ -679,6 +862,7 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         startInfo.reloaded = false;
         break;
     } case EndPlayback: {
+        scrubSeeking = false;
         Mrl mrl; int reason; _TakeData(event, mrl, reason);
         int remain = (this->duration + this->begin) - this->position;
         nextInfo = StartInfo();
@@ -716,23 +900,39 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         break;
     } case NotifySeek:
         emit p->sought();
+        if (_Change(scrubSeeking, false) && scrubbing && scrubTarget != scrubSent)
+            scrubNext();
         break;
     default:
         break;
     }
 }
 
-auto PlayEngine::Data::log(const QByteArray &prefix,
-                           const QByteArray &text) -> void
+// each message is a single line terminated by newline since API 1.6
+auto PlayEngine::Data::log(const mpv_event_log_message *message) -> void
 {
-    Log::write(Log::Info, "[mpv/%%] %%", prefix, text);
-    if (text.startsWith("AO: [")) {
-        constexpr int from = 5;
-        const int to = text.indexOf(']');
-        const auto driver = QString::fromLatin1(text.mid(from, to - from));
+    const char *text = message->text;
+    if (!qstrncmp(text, "AO: [", 5)) {
+        const auto driver = QString::fromLatin1(text + 5, qstrlen(text + 5))
+                            .section(']'_q, 0, 0);
         QMetaObject::invokeMethod(&audioInfo, "setDriver",
                                   Qt::QueuedConnection, Q_ARG(QString, driver));
     }
+    Log::Level lv = Log::Trace;
+    switch (message->log_level) {
+    case MPV_LOG_LEVEL_FATAL:
+    case MPV_LOG_LEVEL_ERROR: lv = Log::Error; break;
+    case MPV_LOG_LEVEL_WARN:  lv = Log::Warn;  break;
+    case MPV_LOG_LEVEL_INFO:  lv = Log::Info;  break;
+    case MPV_LOG_LEVEL_V:     lv = Log::Debug; break;
+    default:                                   break;
+    }
+    Log::write("mpv", lv, [&] () {
+        QByteArray line = '[' + QByteArray(message->prefix) + "] "_b + text;
+        if (line.endsWith('\n'))
+            line.chop(1);
+        return line;
+    });
 }
 
 auto PlayEngine::Data::takeSnapshot() -> void
@@ -743,36 +943,42 @@ auto PlayEngine::Data::takeSnapshot() -> void
         emit p->snapshotTaken();
         return;
     }
-    OpenGLFramebufferObject fbo(size);
+    auto pool = OpenGLTexturePool::current();
+    auto fbo = pool->acquireFramebufferObject(size);
     auto take = [&](bool withOsd) -> QImage {
         QImage image;
         if (withOsd && !p->subtitleStreams().isEmpty()) {
             const auto was = getmpv<bool>("sub-visibility");
             if (was != withOsd)
                 setmpv("sub-visibility", withOsd);
-            render(&fbo);
+            render(fbo);
             if (was != withOsd)
                 setmpv("sub-visibility", was);
-            return fbo.texture().toImage();
+            return fbo->toImage();
         }
         if (!ssNoOsd.isNull())
             return ssNoOsd;
-        render(&fbo);
-        return fbo.texture().toImage();
+        render(fbo);
+        return fbo->toImage();
     };
     if (snapshot & VideoOnly)
         ssNoOsd = take(false);
     if (snapshot & VideoWidthOsd)
         ssWithOsd = take(true);
+    pool->release(fbo);
     emit p->snapshotTaken();
 }
 
 auto PlayEngine::Data::renderVideoFrame(OpenGLFramebufferObject *fbo) -> void
 {
+    _TraceScope("PlayEngine::renderVideoFrame");
     const int delay = render(fbo);
+    StartupTimeline::finish("first frame");
     fpsMeasure.push(++drawnFrames);
     videoInfo.setDelayedFrames(delay);
     videoInfo.setDroppedFrames(getmpv<int64_t>("vo-drop-frame-count"));
+    if (adaptiveDecoding)
+        controlDecoderQuality(delay);
 
     _Trace("PlayEngine::Data::renderVideoFrame(): "
            "render queued frame(%%), avgfps: %%",
@@ -783,3 +989,45 @@ auto PlayEngine::Data::renderVideoFrame(OpenGLFramebufferObject *fbo) -> void
         snapshot = NoSnapshot;
     }
 }
+
+auto PlayEngine::Data::updateIdle() -> void
+{
+    const auto now = _SystemTime();
+    if (!(state & Playing)) {
+        idleSince = now;
+        idleWakeups = wakeups;
+    } else if (idleSince) {
+        const double sec = (now - idleSince) * 1e-6;
+        _Debug("Idle for %%s with %% wakeups", sec, wakeups - idleWakeups);
+        idleSince = 0;
+    }
+}
+
+auto PlayEngine::Data::controlDecoderQuality(int queued) -> void
+{
+    const auto now = _SystemTime();
+    if (now - decoderQualityChecked < 250000)
+        return;
+    decoderQualityChecked = now;
+    if (!(state & Playing) || videoInfo.hwacc()->state() == Activated)
+        return;
+    const double fps = videoInfo.input()->fps() * speed;
+    if (fps <= 0.0)
+        return;
+    const auto decodeTime = getmpv<double>("decode-frame-time");
+    if (decoderQuality.update(decodeTime, 1.0/fps, queued,
+                              videoInfo.droppedFrames()))
+        applyDecoderQuality();
+}
+
+auto PlayEngine::Data::applyDecoderQuality() -> void
+{
+    const auto &opts = decoderQuality.options();
+    _Debug("Decoder quality level: %% (skiploopfilter=%%, skipframe=%%, "
+           "fast=%%)", decoderQuality.level(), opts.skipLoopFilter,
+           opts.skipFrame, opts.fast);
+    setmpv_async("options/vd-lavc-skiploopfilter",
+                 QByteArray(opts.skipLoopFilter));
+    setmpv_async("options/vd-lavc-skipframe", QByteArray(opts.skipFrame));
+    setmpv_async("options/vd-lavc-fast", opts.fast);
+}
@@ -18,6 +18,7 @@
 #include "video/videorenderer.hpp"
 #include "video/videofilter.hpp"
 #include "video/videocolor.hpp"
+#include "video/decoderqualitycontroller.hpp"
 #include "subtitle/submisc.hpp"
 #include "misc/osdstyle.hpp"
 #include "misc/speedmeasure.hpp"
@@ -43,7 +44,8 @@ DECLARE_LOG_CONTEXT(Engine)
 
 enum EventType {
     UserType = QEvent::User, StateChange, WaitingChange,
-    PreparePlayback,EndPlayback, StartPlayback, NotifySeek,
+    PreparePlayback,EndPlayback, StartPlayback, NotifySeek, FlushUpdates,
+    AsyncReply,
     EventTypeMax
 };
 
@@ -52,6 +54,10 @@ enum MpvState {
 };
 
 static constexpr const int UpdateEventBegin = QEvent::User + 1000;
+// QML bindings on time need not follow every frame
+static constexpr const int TimeNotifyInterval = 50;
+// synchronous mpv call longer than this in GUI thread is reported
+static constexpr const qint64 BlockingCallLimit = 5;
 
 struct StreamTypeInfo {
     StreamType type;
@@ -86,7 +92,9 @@ static const QVector<StreamType> streamTypes
 struct Observation {
     int event;
     const char *name = nullptr;
-    std::function<void(void)> post; // post from mpv to qt
+    mpv_format format = MPV_FORMAT_NONE; // value type delivered by mpv
+    bool coalesce = false; // only the latest one is handled at each flush
+    std::function<void(const mpv_event_property*)> post; // post from mpv to qt
     std::function<void(QEvent*)> handle; // handle posted event
 };
 
@@ -189,6 +197,17 @@ private:
 template<class T>
 using mpv_type = typename mpv_format_trait<T>::mpv_type;
 
+using AsyncDone = std::function<void(int error)>;
+
+// mpv request sent asynchronously. reply is handled in GUI thread.
+struct AsyncRequest {
+    QByteArray desc; // shown on error
+    QByteArray key; // non-empty to drop stale ones which have not been sent
+    std::function<int(quint64 id)> send;
+    AsyncDone done;
+    quint64 order = 0; // order of issue while waiting
+};
+
 struct StreamData {
     StreamList tracks;
     QStringList priority;
@@ -224,6 +243,11 @@ struct PlayEngine::Data {
     bool hasImage = false, tempoScaler = false, seekable = false, hasVideo = false;
     bool subStreamsVisible = true, startPaused = false, disc = false;
     bool pauseAfterSkip = false;
+    // keyframe seek is sent only after previous one has been done
+    bool scrubbing = false, scrubSeeking = false;
+    int scrubTarget = -1, scrubSent = -1;
+    auto scrub(int pos) -> void;
+    auto scrubNext() -> void;
     AudioController *audio = nullptr;
     bool quit = false, muted = false, initialized = false;
     int volume = 100, avSync = 0;
@@ -247,6 +271,10 @@ struct PlayEngine::Data {
     QVector<StreamData> streams = {StreamData(), StreamData(), StreamData()};
     Mrl mpvMrl;
     mpv_opengl_cb_context *glMpv = nullptr;
+    // on_preloaded hook is held until GL context is given
+    QMutex glMutex;
+    bool glInitialized = false, glWaiting = false;
+    QSemaphore ready; // released when mpv has been initialized
     QMatrix4x4 c_matrix;
     VideoColor videoEq;
     VideoEffects videoEffects = 0;
@@ -262,6 +290,7 @@ struct PlayEngine::Data {
     DeintOption deint_swdec, deint_hwdec;
     DeintMode deint = DeintMode::Auto;
     QString audioDevice = u"auto"_q;
+    QVariantList audioDevices; // observed not to read it on GUI thread
 
     StartInfo startInfo, nextInfo;
 
@@ -272,6 +301,13 @@ struct PlayEngine::Data {
     bool hqUpscaling = false, hqDownscaling = false;
     quint64 drawnFrames = 0, droppedFrames = 0, delayedFrames = 0;
     SpeedMeasure<quint64> fpsMeasure{5, 20};
+    DecoderQualityController decoderQuality;
+    bool adaptiveDecoding = false;
+    quint64 decoderQualityChecked = 0;
+    // playloop wakeups, which should be rare while not playing
+    std::atomic<quint64> wakeups{0};
+    quint64 idleSince = 0, idleWakeups = 0;
+    std::atomic<bool> videoVisible{true};
 
     QImage ssNoOsd, ssWithOsd;
 
@@ -290,8 +326,11 @@ struct PlayEngine::Data {
                 emit p->stoppedChanged();
             if (check(Running))
                 emit p->runningChanged();
+            if (check(Playing))
+                updateIdle();
         }
     }
+    auto updateIdle() -> void;
 
     auto setWaitings(Waitings w, bool set) -> void
     {
@@ -312,6 +351,11 @@ struct PlayEngine::Data {
         videoInfo.setDelayedFrames(0);
         videoInfo.renderer()->setFps(0);
         drawnFrames = 0;
+        const bool degraded = decoderQuality.level() > 0;
+        decoderQuality.reset();
+        decoderQualityChecked = 0;
+        if (degraded)
+            applyDecoderQuality();
     }
 
     auto af() const -> QByteArray;
@@ -321,6 +365,8 @@ struct PlayEngine::Data {
     auto updateVideoSubOptions() -> void;
     auto updateColorMatrix() -> void;
     auto renderVideoFrame(OpenGLFramebufferObject *fbo) -> void;
+    auto controlDecoderQuality(int queued) -> void;
+    auto applyDecoderQuality() -> void;
     auto displaySize() const { return videoInfo.renderer()->size(); }
     auto post(State state) -> void { _PostEvent(p, StateChange, state); }
     auto post(Waitings w, bool set) -> void { _PostEvent(p, WaitingChange, w, set); }
@@ -333,9 +379,42 @@ struct PlayEngine::Data {
     SIA qbytearray_from(const QByteArray &t) -> QByteArray { return t; }
     SIA qbytearray_from(const QString &t) -> QByteArray { return t.toLocal8Bit(); }
 
+    template<class F>
+    auto blocking(const QByteArray &what, F &&call) -> int
+    {
+        if (QThread::currentThread() != p->thread())
+            return call();
+        QElapsedTimer timer; timer.start();
+        const int err = call();
+        const auto elapsed = timer.elapsed();
+        if (elapsed > BlockingCallLimit)
+            _Warn("'%%' blocked GUI thread for %%ms.", what, elapsed);
+        return err;
+    }
+
+    // requests with same key are sent one by one and only the latest one
+    // waits for the previous reply. waiting ones are sent before any request
+    // issued after them so that requests reach mpv in the issued order.
+    QMutex asyncMutex;
+    quint64 asyncId = 0, asyncOrder = 0;
+    QHash<quint64, AsyncRequest> asyncSent;
+    QHash<QByteArray, int> asyncFlying; // number of sent ones for each key
+    QHash<QByteArray, AsyncRequest> asyncWaiting;
+    auto request(AsyncRequest &&req) -> void;
+    // below two need asyncMutex locked
+    auto send(AsyncRequest &&req) -> void;
+    auto sendWaiting(quint64 order) -> void;
+    // stale ones should not be applied to next file
+    auto dropWaiting() -> void;
+    auto reply(quint64 id, int error) -> void;
+    auto command(const QByteArray &key, QList<QByteArray> &&args,
+                 AsyncDone &&done) -> void;
+
     auto tellmpv(const QByteArray &cmd) -> void;
     auto tellmpv_async(const QByteArray &cmd,
-                       std::initializer_list<QByteArray> &&list) -> void;
+                       std::initializer_list<QByteArray> &&list,
+                       AsyncDone &&done = nullptr) -> void
+        { command(QByteArray(), QList<QByteArray>() << cmd << list, std::move(done)); }
     auto tellmpv(const QByteArray &cmd,
                  std::initializer_list<QByteArray> &&list) -> void;
     template<class... Args>
@@ -344,6 +423,10 @@ struct PlayEngine::Data {
     template<class... Args>
     auto tellmpv_async(const QByteArray &cmd, const Args &... args) -> void
         { tellmpv_async(cmd, {qbytearray_from(args)...}); }
+    // previous one is dropped if it is still waiting
+    template<class... Args>
+    auto tellmpv_latest(const QByteArray &cmd, const Args &... args) -> void
+        { command(cmd, {cmd, qbytearray_from(args)...}, nullptr); }
 
     auto updateMrl() -> void;
     auto loadfile(int resume) -> void;
@@ -352,14 +435,24 @@ struct PlayEngine::Data {
     auto loadfile() -> void { loadfile(startInfo.resume); }
     auto updateMediaName(const QString &name = QString()) -> void;
     template <class T>
-    auto setmpv_async(const char *name, const T &value) -> void;
+    auto setmpv_async(const QByteArray &key, const char *name,
+                      const T &value, AsyncDone &&done) -> void;
+    template <class T>
+    auto setmpv_async(const char *name, const T &value,
+                      AsyncDone &&done = nullptr) -> void
+        { setmpv_async(QByteArray(), name, value, std::move(done)); }
+    // previous value is dropped if it is still waiting
+    template <class T>
+    auto setmpv_latest(const char *name, const T &value) -> void
+        { setmpv_async(name, name, value, nullptr); }
     template <class T>
     auto setmpv(const char *name, const T &value) -> void;
     template<class T>
     auto getmpv(const char *name) -> T;
     template<class T>
     auto getmpv(const char *name, T &val) -> bool;
-    auto refresh() -> void {tellmpv("frame_step"); tellmpv("frame_back_step");}
+    auto refresh() -> void
+        { tellmpv_async("frame_step"); tellmpv_async("frame_back_step"); }
     static auto error(int err) -> const char* { return mpv_error_string(err); }
     auto isSuccess(int error) -> bool { return error == MPV_ERROR_SUCCESS; }
     template<class T>
@@ -369,32 +462,65 @@ struct PlayEngine::Data {
     template<class... Args>
     auto fatal(int err, const char *msg, const Args &... args) -> void;
     auto getmpvosd(const char *name) -> QString {
-        auto buf = mpv_get_property_osd_string(handle, name);
+        char *buf = nullptr;
+        if (handle)
+            blocking(name, [&] () {
+                buf = mpv_get_property_osd_string(handle, name);
+                return MPV_ERROR_SUCCESS;
+            });
         auto ret = QString::fromLatin1(buf);
         mpv_free(buf);
         return ret;
     }
 
-    auto observation(int event) -> const Observation&
+    auto observation(int event) -> Observation&
     {
         Q_ASSERT(UpdateEventBegin <= event && event < updateEventMax);
         Q_ASSERT(event == observations[event - UpdateEventBegin].event);
         return observations[event - UpdateEventBegin];
     }
     auto newUpdateEvent() -> int { return updateEventMax++; }
-    auto observe(const char *name, std::function<void(void)> &&post) -> int
+    template<class T>
+    SIA cast(const mpv_event_property *ev, const T &fallback = T()) -> T
     {
-        const int event = newUpdateEvent();
-        Observation ob;
-        ob.event = event;
-        ob.name = name;
-        ob.post = post;
-        ob.handle = [] (QEvent*) {};
-        observations.append(ob);
-        Q_ASSERT(observations.size() == updateEventMax - UpdateEventBegin);
-        return event;
+        using trait = mpv_format_trait<T>;
+        if (ev->format != trait::format || !ev->data)
+            return fallback;
+        return trait::cast(*static_cast<const mpv_type<T>*>(ev->data));
+    }
+    // coalesced changes are kept here until GUI thread flushes them
+    QMutex updateMutex;
+    QVector<QEvent*> updates, flushing;
+    bool flushPosted = false;
+    QTimer flusher;
+    QElapsedTimer flushed;
+    int flushInterval = 16;
+    template<class T>
+    auto update(int event, const T &value) -> void
+    {
+        const int idx = event - UpdateEventBegin;
+        if (!observations[idx].coalesce) {
+            _PostEvent(p, event, value);
+            return;
+        }
+        QEvent *e = new DataEvent<T>(event, value);
+        updateMutex.lock();
+        std::swap(updates[idx], e);
+        const bool post = _Change(flushPosted, true);
+        updateMutex.unlock();
+        delete e;
+        if (post)
+            _PostEvent(p, FlushUpdates);
     }
-    template<class Get>
+    auto coalesce(int event) -> void { observation(event).coalesce = true; }
+    QTimer timeNotifier;
+    int notifiedTime = -1;
+    auto notifyTime() -> void;
+    auto requestFlush() -> void;
+    auto flushUpdates() -> void;
+
+    // mpv delivers value as M in event and get converts it to posted one
+    template<class M, class Get>
     auto observe(const char *name, Get get,
                  std::function<void(QEvent*)> &&handle) -> int
     {
@@ -402,7 +528,8 @@ struct PlayEngine::Data {
         Observation ob;
         ob.event = event;
         ob.name = name;
-        ob.post = [=] () { _PostEvent(p, event, get()); };
+        ob.format = mpv_format_trait<M>::format;
+        ob.post = [=] (const mpv_event_property *ev) { update(event, get(ev)); };
         ob.handle = handle;
         observations.append(ob);
         Q_ASSERT(observations.size() == updateEventMax - UpdateEventBegin);
@@ -411,14 +538,15 @@ struct PlayEngine::Data {
     template<class T, class Set>
     auto observeType(const char *name, Set set) -> int
     {
-        return observe(name, [=] () { return getmpv<T>(name); },
-                       [=] (QEvent *e) { set(_MoveData<T>(e)); });
+        return observe<T>(name, [] (const mpv_event_property *ev)
+                          { return cast<T>(ev); },
+                          [=] (QEvent *e) { set(_MoveData<T>(e)); });
     }
 
-    template<class T, class Get, class Notify>
-    auto observe(const char *name, T &t, Get get, Notify notify) -> int
+    template<class M, class T, class Get, class Notify>
+    auto observeAs(const char *name, T &t, Get get, Notify notify) -> int
     {
-        return observe<Get>(name, get, [=, &t] (QEvent *e) {
+        return observe<M>(name, get, [=, &t] (QEvent *e) {
             if (t != _GetData<T>(e)) {
                 _TakeData(e, t);
                 if (initialized)
@@ -427,39 +555,38 @@ struct PlayEngine::Data {
         });
     }
 
-    template<class T, class Get>
+    template<class M, class T, class Get>
     auto observe(const char *name, T &t, Get get, void(PlayEngine::*sig)()) -> int
-        { return observe<T, Get>(name, t, get, [=] () { emit (p->*sig)(); }); }
+        { return observeAs<M>(name, t, get, [=] () { emit (p->*sig)(); }); }
 
-    template<class T, class Get, class S>
+    template<class M, class T, class Get, class S>
     auto observe(const char *name, T &t, Get get, void(PlayEngine::*sig)(S)) -> int
-        { return observe<T, Get>(name, t, get, [=, &t] () { emit (p->*sig)(t); }); }
+        { return observeAs<M>(name, t, get, [=, &t] () { emit (p->*sig)(t); }); }
 
     template<class T>
     auto observe(const char *name, T &t, void(PlayEngine::*sig)()) -> int
     {
-        return observe(name, t, [=, &t] () {
-            T val = t; return getmpv<T>(name, val) ? val : T();
-        }, sig);
+        return observe<T>(name, t, [] (const mpv_event_property *ev)
+                          { return cast<T>(ev); }, sig);
     }
 
     template<class T, class S>
     auto observe(const char *name, T &t, void(PlayEngine::*sig)(S)) -> int
     {
-        return observe(name, t, [=, &t] () {
-            T val = t; return getmpv<T>(name, val) ? val : T();
-        }, sig);
+        return observe<T>(name, t, [] (const mpv_event_property *ev)
+                          { return cast<T>(ev); }, sig);
     }
     auto observeTime(const char *name, int &t, void(PlayEngine::*sig)(int)) -> int
     {
-        return observe<int>(name, t, [=, &t] { return s2ms(getmpv<double>(name)); }, sig);
+        return observe<double>(name, t, [] (const mpv_event_property *ev)
+                               { return s2ms(cast<double>(ev)); }, sig);
     }
 
     auto observeTrack(StreamType type) -> int
     {
         const auto &info = streamTypeInfo[type];
-        return observe(info.mpvName, [=, &info] () {
-            int track = 0; return getmpv<int>(info.mpvName, track) ? track : 1;
+        return observe<int>(info.mpvName, [] (const mpv_event_property *ev) {
+            return cast<int>(ev, 1);
         }, [=] (QEvent *event) { setCurrentTrack(type, _GetData<int>(event)); });
     }
     auto setStreamList(StreamType type, StreamList &&list) -> bool;
@@ -480,7 +607,7 @@ struct PlayEngine::Data {
     auto observe() -> void;
     auto dispatch(mpv_event *event) -> void;
     auto process(QEvent *event) -> void;
-    auto log(const QByteArray &prefix, const QByteArray &text) -> void;
+    auto log(const mpv_event_log_message *message) -> void;
     int hookId = 0;
     template<class F>
     auto hook(const QByteArray &when, F &&handler) -> void
@@ -490,19 +617,21 @@ struct PlayEngine::Data {
         hooks[when] = std::move(handler);
     }
     auto hook() -> void;
-    QMap<QByteArray, std::function<void(void)>> hooks;
+    // handler returns false to acknowledge later by itself
+    QMap<QByteArray, std::function<bool(void)>> hooks;
     QPoint mouse;
     auto setMousePos(const QPointF &pos)
     {
         if (!_Change(mouse, video->mapToVideo(pos).toPoint()))
             return false;
-        tellmpv("mouse"_b, mouse.x(), mouse.y());
+        tellmpv_latest("mouse"_b, mouse.x(), mouse.y());
 //        mpv_opengl_cb_set_mouse_pos(glMpv, mouse.x(), mouse.y());
         return true;
     }
     auto render(OpenGLFramebufferObject *fbo) -> int
     {
-        int vp[4] = {0, 0, fbo->width(), fbo->height()};
+        const auto size = fbo->viewport();
+        int vp[4] = {0, 0, size.width(), size.height()};
         return mpv_opengl_cb_render(glMpv, fbo->id(), vp);
     }
     auto takeSnapshot() -> void;
@@ -521,16 +650,21 @@ auto PlayEngine::Data::post(mpv_event *event, T &val, const T &fb) -> void
 }
 
 template <class T>
-auto PlayEngine::Data::setmpv_async(const char *name, const T &value) -> void
+auto PlayEngine::Data::setmpv_async(const QByteArray &key, const char *name,
+                                    const T &value, AsyncDone &&done) -> void
 {
-    if (handle) {
+    static_assert(!std::is_pointer<T>::value, "value should be kept until sent");
+    const QByteArray prop(name);
+    AsyncRequest req;
+    req.key = key;
+    req.desc = prop + '=' + mpv_format_trait<T>::userdata(value);
+    req.done = std::move(done);
+    req.send = [=] (quint64 id) {
         mpv_type<T> data = value;
-        auto userdata = new QByteArray(name);
-        *userdata += "=" + mpv_format_trait<T>::userdata(value);
-        check(mpv_set_property_async(handle, (quint64)(void*)userdata, name,
-                                     mpv_format_trait<T>::format, &data),
-              "Error on %%", *userdata);
-    }
+        return mpv_set_property_async(handle, id, prop.constData(),
+                                      mpv_format_trait<T>::format, &data);
+    };
+    request(std::move(req));
 }
 
 template <class T>
@@ -538,9 +672,10 @@ auto PlayEngine::Data::setmpv(const char *name, const T &value) -> void
 {
     if (handle) {
         mpv_type<T> data = value;
-        check(mpv_set_property(handle, name, mpv_format_trait<T>::format,
-                               &data),
-              "Error on %%=%%", name, value);
+        check(blocking(name, [&] () {
+            return mpv_set_property(handle, name, mpv_format_trait<T>::format,
+                                    &data);
+        }), "Error on %%=%%", name, value);
     }
 }
 
@@ -549,9 +684,9 @@ auto PlayEngine::Data::getmpv(const char *name, T &def) -> bool
 {
     using trait = mpv_format_trait<T>;
     mpv_type<T> data;
-    if (!handle || !check(mpv_get_property(handle, name,
-                                           trait::format, &data),
-                          "Couldn't get property '%%'.", name))
+    if (!handle || !check(blocking(name, [&] () {
+            return mpv_get_property(handle, name, trait::format, &data);
+        }), "Couldn't get property '%%'.", name))
         return false;
     def = trait::cast(data);
     if (trait::use_free)
@@ -120,6 +120,7 @@ public:
     P0(int, sub_pos_step, 1)
     P0(bool, enable_hwaccel, true)
     P0(QStringList, hwaccel_codecs, defaultHwAccCodecs())
+    P0(bool, enable_adaptive_decoding, true)
     QVector<DeintMethod> hwdeints = defaultHwAccDeints();
     P0(DeintCaps, deint_hwdec, DeintCaps::default_(DecoderDevice::GPU))
     P0(DeintCaps, deint_swdec, DeintCaps::default_(DecoderDevice::CPU))
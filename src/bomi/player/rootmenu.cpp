@@ -278,6 +278,9 @@ RootMenu::RootMenu()
     d->parent = this;
     d->infos[menuAction()] = {QString(), [](){}};
 
+    // built eagerly: actions carry shortcuts and ids for execute(),
+    // and MainWindow connects to them right after construction
+
     d->menu(u"open"_q, QT_TR_NOOP("Open"), [=] () {
         d->action(u"file"_q, QT_TR_NOOP("Open File"));
         d->action(u"folder"_q, QT_TR_NOOP("Open Folder"));
@@ -506,6 +509,7 @@ RootMenu::RootMenu()
         d->action(u"find-subtitle"_q, QT_TR_NOOP("Find Subtitle"));
         d->action(u"subtitle"_q, QT_TR_NOOP("Subtitle View"));
         d->action(u"playinfo"_q, QT_TR_NOOP("Playback Information"));
+        d->action(u"trace"_q, QT_TR_NOOP("Record Trace Events"), true);
 
         d->separator();
 
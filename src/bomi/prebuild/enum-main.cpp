@@ -263,7 +263,28 @@ static void generate() {
     overwrite("../enum/enums.cpp", cpp);
 }
 
+static void generateMrlStateFields() {
+    cout << "Generate MrlState fields" << endl;
+    fstream in;
+    in.open("mrlstate-list", ios::in);
+    assert(in.is_open());
+    string fields, read;
+    while (getline(in, read)) {
+        const string name = trim(read);
+        if (name.empty() || name[0] == '#')
+            continue;
+        fields += "    _MrlStateField<decltype(MrlState::" + name + "), &MrlState::"
+                + name + ">(\"" + name + "\"),\n";
+    }
+    string hpp = "// generated from mrlstate-list by prebuild/enum-main.cpp\n"
+                 "// included only in mrlstatesqlfield.cpp\n\n"
+                 "static const MrlStateFieldIO MrlStateFields[] = {\n";
+    hpp += fields + "};\n";
+    overwrite("../player/mrlstatefields.hpp", hpp);
+}
+
 int main() {
     generate();
+    generateMrlStateFields();
     return 0;
 }
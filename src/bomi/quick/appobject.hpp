@@ -4,6 +4,7 @@
 class PlayEngine;                       class HistoryModel;
 class PlaylistModel;                    class TopLevelItem;
 class Downloader;                       class ThemeObject;
+class SubtitleRendererItem;
 
 class AppObject : public QObject {
     Q_OBJECT
@@ -13,6 +14,7 @@ class AppObject : public QObject {
     Q_PROPERTY(TopLevelItem *topLevelItem READ topLevelItem CONSTANT FINAL)
     Q_PROPERTY(Downloader *download READ downloader CONSTANT FINAL)
     Q_PROPERTY(ThemeObject *theme READ theme CONSTANT FINAL)
+    Q_PROPERTY(SubtitleRendererItem *subtitle READ subtitle CONSTANT FINAL)
 public:
     PlayEngine *engine() const { return s.engine; }
     HistoryModel *history() const { return s.history; }
@@ -20,12 +22,14 @@ public:
     TopLevelItem *topLevelItem() const { return s.top; }
     Downloader *downloader() const { return s.down; }
     ThemeObject *theme() const { return s.theme; }
+    SubtitleRendererItem *subtitle() const { return s.subtitle; }
     static auto setTheme(ThemeObject *theme) -> void { s.theme = theme; }
     static auto setEngine(PlayEngine *engine) -> void { s.engine = engine; }
     static auto setHistory(HistoryModel *history) -> void { s.history = history; }
     static auto setPlaylist(PlaylistModel *pl) -> void { s.playlist = pl; }
     static auto setTopLevelItem(TopLevelItem *top) -> void { s.top = top; }
     static auto setDownloader(Downloader *down) -> void { s.down = down; }
+    static auto setSubtitle(SubtitleRendererItem *sub) -> void { s.subtitle = sub; }
 private:
     struct StaticData {
         PlayEngine *engine = nullptr;
@@ -34,6 +38,7 @@ private:
         TopLevelItem *top = nullptr;
         Downloader *down = nullptr;
         ThemeObject *theme = nullptr;
+        SubtitleRendererItem *subtitle = nullptr;
     };
     static StaticData s;
 };
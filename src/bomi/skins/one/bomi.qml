@@ -144,6 +144,7 @@ B.AppWithFloating {
                         setRate(mouse.x, mouse.y)
                 }
                 onPositionChanged: { setRate(mouse.x, mouse.y) }
+                onPressedChanged: engine.scrubbing = pressed
             }
 
             B.Button {
@@ -23,6 +23,7 @@ char *gets(char *str);
 #include <cmath>
 #include <cstdint>
 #include <deque>
+#include <atomic>
 #include <algorithm>
 
 #ifdef Q_OS_LINUX
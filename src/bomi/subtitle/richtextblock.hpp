@@ -49,6 +49,7 @@ class RichTextBlockParser : public RichTextHelper {
 public:
     RichTextBlockParser(const QStringRef &text);
     auto atEnd() const -> bool {return m_pos >= m_text.size();}
+    auto pos() const -> int { return m_pos; }
     auto get(const QString &open, const QString &close,
              Tag *tag = nullptr) -> QStringRef;
     auto paragraph(Tag *tag = nullptr) -> QList<RichTextBlock>;
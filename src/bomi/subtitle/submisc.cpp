@@ -130,23 +130,24 @@ auto SubtitleStateInfo::append(const SubComp &c) -> void
     m_bomi[c.fileInfo()].append({c.id(), c.selection()});
 }
 
-auto SubtitleStateInfo::load() const -> QVector<SubComp>
+auto SubtitleStateInfo::take(const Subtitle &sub) -> QVector<SubComp>
 {
     auto selected = [] (const QVector<Comp> &list, int id) {
         for (auto &c : list) { if (c.id == id) return c.selected; }
         return false;
     };
     QVector<SubComp> loaded;
-    Subtitle sub;
-    for (auto it = m_bomi.begin(); it != m_bomi.end(); ++it) {
-        if (!sub.load(it.key().path, it.key().encoding, -1))
-            continue;
-        if (sub.size() != it->size())
-            continue;
-        for (int i=0; i<sub.size(); ++i) {
-            loaded.append(sub[i]);
-            loaded.last().selection() = selected(*it, loaded.last().id());
-        }
+    if (sub.isEmpty())
+        return loaded;
+    const auto it = m_bomi.find(sub[0].fileInfo());
+    if (it == m_bomi.end() || !(it.key() == sub[0].fileInfo()))
+        return loaded;
+    // selection is meaningless if file has been changed since saved
+    const bool same = sub.size() == it->size();
+    for (int i=0; i<sub.size(); ++i) {
+        loaded.append(sub[i]);
+        loaded.last().selection() = same && selected(*it, loaded.last().id());
     }
+    m_bomi.erase(it);
     return loaded;
 }
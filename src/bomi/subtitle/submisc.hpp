@@ -2,6 +2,7 @@
 #define SUBMISC_HPP
 
 class SubComp;
+class Subtitle;
 
 struct SubtitleFileInfo {
     SubtitleFileInfo() {}
@@ -52,11 +53,14 @@ struct SubtitleStateInfo {
     auto append(const SubComp &comp) -> void;
     auto bomi() const -> const QMap<SubtitleFileInfo, QVector<Comp>>&
         { return m_bomi; }
+    auto bomi() -> QMap<SubtitleFileInfo, QVector<Comp>>& { return m_bomi; }
     auto mpv() const -> const QVector<SubtitleFileInfo>& { return m_mpv; }
     auto mpv() -> QVector<SubtitleFileInfo>& { return m_mpv; }
     auto setTrack(int track) -> void { m_track = track; m_valid = true; }
     auto getTrack() const -> int { return m_track; }
-    auto load() const -> QVector<SubComp>;
+    // components of parsed file with saved selection or empty if sub is not
+    // a file of this state. each file is taken only once
+    auto take(const Subtitle &sub) -> QVector<SubComp>;
     auto isValid() const -> bool { return m_valid; }
 private:
     bool m_valid = false;
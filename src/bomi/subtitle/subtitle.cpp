@@ -31,6 +31,87 @@ SubComp::SubComp(SubType type, const QFileInfo &file, const QString &enc, int id
     m_capts[0].index = 0;
 }
 
+static auto writeBlock(QDataStream &out, const RichTextBlock &block) -> void
+{
+    out << block.text << block.paragraph << block.formats.size();
+    for (auto &format : block.formats)
+        out << format.style << format.begin << format.end;
+    out << block.rubies.size();
+    for (auto &ruby : block.rubies) {
+        out << ruby.rb_begin << ruby.rb_end;
+        writeBlock(out, ruby.rt_block);
+    }
+}
+
+static auto readBlock(QDataStream &in, RichTextBlock &block) -> void
+{
+    int count = 0;
+    in >> block.text >> block.paragraph >> count;
+    block.formats.resize(count);
+    for (auto &format : block.formats)
+        in >> format.style >> format.begin >> format.end;
+    in >> count;
+    block.rubies.resize(count);
+    for (auto &ruby : block.rubies) {
+        in >> ruby.rb_begin >> ruby.rb_end;
+        readBlock(in, ruby.rt_block);
+    }
+}
+
+// no count is written so that records can be concatenated as they are
+auto SubComp::encode(const QList<RichTextBlock> &blocks) -> QByteArray
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    for (auto &block : blocks)
+        writeBlock(out, block);
+    return data;
+}
+
+auto SubComp::decode(const QByteArray &data) -> QList<RichTextBlock>
+{
+    QList<RichTextBlock> blocks;
+    QDataStream in(data);
+    while (!in.atEnd() && in.status() == QDataStream::Ok) {
+        blocks.push_back(RichTextBlock());
+        readBlock(in, blocks.last());
+    }
+    return blocks;
+}
+
+auto SubComp::document(ConstIt it) const -> RichTextDocument
+{
+    RichTextDocument doc;
+    doc = blocks(it);
+    return doc;
+}
+
+auto SubComp::text(ConstIt it) const -> QString
+{
+    QString text;
+    for (auto &block : blocks(it))
+        text += block.text;
+    return text;
+}
+
+auto SubComp::append(int key, const QList<RichTextBlock> &blocks) -> void
+{
+    auto &capt = m_capts[key];
+    if (blocks.isEmpty())
+        return;
+    // caption grows at the end of arena so move it there unless it is last
+    if (capt.offset + capt.size != m_data.size()) {
+        const auto moved = m_data.mid(capt.offset, capt.size);
+        capt.offset = m_data.size();
+        m_data += moved;
+    }
+    const auto encoded = encode(blocks);
+    m_data += encoded;
+    capt.size += encoded.size();
+    for (int i = 0; i < blocks.size() && !capt.words; ++i)
+        capt.words = blocks[i].hasWords();
+}
+
 auto SubComp::united(const SubComp &other, double frameRate) const -> SubComp
 {
     return SubComp(*this).unite(other, frameRate);
@@ -40,7 +121,8 @@ auto SubComp::start(int time, double frameRate) const -> const_iterator
 {
     if (isEmpty() || time < 0)
         return end();
-    return --finish(time, frameRate);
+    const auto it = finish(time, frameRate);
+    return it == begin() ? end() : it - 1;
 }
 
 auto SubComp::finish(int time, double frameRate) const -> const_iterator
@@ -56,52 +138,48 @@ auto SubComp::finish(int time, double frameRate) const -> const_iterator
     return upperBound(key);
 }
 
+// linear merge: caption at each key of both is the concatenation of
+// captions which are shown at that time in each
 auto SubComp::unite(const SubComp &rhs, double fps) -> SubComp&
 {
     if (this == &rhs || rhs.isEmpty())
         return *this;
     else if (isEmpty())
         return *this = rhs;
-    auto convertKeyBase = [this] (int key, SyncType from, SyncType to,
-                                  double frameRate) {
-        return  (from == to) ? key : ((to == Time) ? msec(key, frameRate)
-                                                   : frame(key, frameRate));
+    auto convert = [&] (int key) {
+        if (rhs.base() == m_base)
+            return key;
+        return m_base == Time ? msec(key, fps) : frame(key, fps);
     };
-
-    auto it1 = m_capts.begin();
-    auto it2 = rhs.begin();
-    const auto k2 = convertKeyBase(it2.key(), rhs.base(), m_base, fps);
-    if (it2.key() < it1.key()) {
-        while (k2 < it1.key()) {
-            m_capts.insert(k2, *it2);
-            ++it2;
+    Map merged;
+    merged.reserve(m_capts.size() + rhs.m_capts.size());
+    QByteArray data;
+    data.reserve(m_data.size() + rhs.m_data.size());
+    const SubCapt *cap1 = nullptr, *cap2 = nullptr;
+    auto it1 = m_capts.cbegin(), it2 = rhs.cbegin();
+    while (it1 != m_capts.cend() || it2 != rhs.cend()) {
+        const int k1 = it1 != m_capts.cend() ? it1.key() : _Max<int>();
+        const int k2 = it2 != rhs.cend() ? convert(it2.key()) : _Max<int>();
+        const int key = qMin(k1, k2);
+        for (; it1 != m_capts.cend() && it1.key() == key; ++it1)
+            cap1 = &*it1;
+        for (; it2 != rhs.cend() && convert(it2.key()) == key; ++it2)
+            cap2 = &*it2;
+        SubCapt capt;
+        capt.offset = data.size();
+        if (cap1) {
+            data.append(m_data.constData() + cap1->offset, cap1->size);
+            capt.words = cap1->words;
         }
-    } else if (k2 == it1.key()){
-        *it1 += *it2;
-        ++it2;
-    } else
-        it1 = --m_capts.lowerBound(k2);
-
-    while (it2 != rhs.end()) {
-        auto &cap1 = *it1;
-//        const int ka = it1.key();
-        const int kb = ++it1 != m_capts.end() ? it1.key() : -1;
-//        Q_ASSERT(ka < k2);
-        int k2 = 0;
-        while (it2 != rhs.end()) {
-            k2 = convertKeyBase(it2.key(), rhs.base(), m_base, fps);
-            if (!(kb == -1 || k2 < kb))
-                break;
-            *m_capts.insert(k2, cap1) += *it2;
-            ++it2;
+        if (cap2) {
+            data.append(rhs.m_data.constData() + cap2->offset, cap2->size);
+            capt.words |= cap2->words;
         }
-        if (it2 == rhs.end())
-            break;
-        if (k2 == kb)
-            *it1 += *it2++;
-        else if (it2 != rhs.begin())
-            *it1 += *(it2-1);
+        capt.size = data.size() - capt.offset;
+        merged.insert(key, capt);
     }
+    m_capts = merged;
+    m_data = data;
 
     auto it = m_capts.begin();
     for (int idx = 0; it != m_capts.end(); ++idx, ++it)
@@ -109,33 +187,50 @@ auto SubComp::unite(const SubComp &rhs, double fps) -> SubComp&
     return *this;
 }
 
-auto Subtitle::caption(int time, double fps) const -> RichTextDocument
+auto SubCompCursor::reset(const SubComp &comp, double fps) -> void
 {
-    if (m_comp.isEmpty())
-        return RichTextDocument();
-    RichTextDocument caption;
-    for (int i=0; i<m_comp.size(); ++i) {
-        const auto it = m_comp[i].start(time, fps);
-        if (it != m_comp[i].end())
-            caption += *it;
+    m_map.clear();
+    m_map.reserve(comp.map().size());
+    m_upper = 0;
+    for (auto it = comp.begin(); it != comp.end(); ++it)
+        m_map.insert(comp.toTime(it.key(), fps), it);
+}
+
+auto SubCompCursor::finish(int time) const -> ConstIt
+{
+    const auto first = m_map.begin();
+    const int size = m_map.size();
+    auto isUpper = [&] (int idx) {
+        return (idx == 0 || (first + (idx - 1)).key() <= time)
+                && (idx == size || time < (first + idx).key());
+    };
+    for (int idx = m_upper; idx <= m_upper + 2 && idx <= size; ++idx) {
+        if (isUpper(idx))
+            return first + (m_upper = idx);
     }
-    return caption;
+    if (m_upper > 0 && isUpper(m_upper - 1))
+        return first + --m_upper;
+    const auto it = m_map.upperBound(time);
+    m_upper = it - first;
+    return it;
 }
 
-auto Subtitle::load(const QString &file, const QString &enc, double acc) -> bool
+auto Subtitle::load(const QString &file, const QString &enc, double acc,
+                    const Control &control) -> bool
 {
     QString encoding;
     if (acc > 0.0)
         encoding = CharsetDetector::detect(file, acc);
     if (encoding.isEmpty())
         encoding = enc;
-    *this = parse(file, encoding);
+    *this = parse(file, encoding, control);
     return !isEmpty();
 }
 
-auto Subtitle::parse(const QString &file, const QString &enc) -> Subtitle
+auto Subtitle::parse(const QString &file, const QString &enc,
+                     const Control &control) -> Subtitle
 {
-    return SubtitleParser::parse(file, enc);
+    return SubtitleParser::parse(file, enc, control);
 }
 
 auto Subtitle::isEmpty() const -> bool
@@ -3,6 +3,7 @@
 
 #include "richtextdocument.hpp"
 #include "submisc.hpp"
+#include "misc/flatmap.hpp"
 
 enum class SubType {
     Unknown,
@@ -12,19 +13,19 @@ enum class SubType {
     MicroDVD
 };
 
-struct SubCapt : public RichTextDocument {
-    SubCapt() {index = -1;}
-    RichTextDocument &doc() {return *this;}
-    const RichTextDocument &doc() const {return *this;}
-    inline SubCapt &operator += (const SubCapt &rhs) {RichTextDocument::operator += (rhs); return *this;}
-    inline SubCapt &operator += (const RichTextDocument &rhs) {RichTextDocument::operator += (rhs); return *this;}
-    inline SubCapt &operator += (const QList<RichTextBlock> &rhs) {RichTextDocument::operator += (rhs); return *this;}
-    mutable int index;
+// caption is kept as serialized blocks in arena of its component because
+// only a few of them are shown at once. document is built on demand.
+struct SubCapt {
+    auto isEmpty() const -> bool { return !size; }
+    auto hasWords() const -> bool { return words; }
+    int offset = 0, size = 0; // range of SubComp::m_data
+    bool words = false;
+    mutable int index = -1;
 };
 
 class SubComp {
 public:
-    using Map = QMap<int, SubCapt>;
+    using Map = FlatMap<int, SubCapt>;
     using It = Map::iterator;
     using ConstIt = Map::const_iterator;
     using iterator = Map::iterator;
@@ -37,6 +38,8 @@ public:
     auto operator != (const SubComp &rhs) const -> bool {return !operator==(rhs);}
     auto operator[] (int key) -> SubCapt& { return m_capts[key]; }
     auto operator[] (int key) const -> SubCapt { return m_capts[key]; }
+    // appends blocks to caption at key
+    auto append(int key, const QList<RichTextBlock> &blocks) -> void;
     auto unite(const SubComp &other, double frameRate) -> SubComp&;
     auto united(const SubComp &other, double frameRate) const -> SubComp;
 
@@ -52,7 +55,12 @@ public:
     auto lowerBound(int key) -> It { return m_capts.lowerBound(key); }
     auto upperBound(int key) const -> ConstIt { return m_capts.upperBound(key); }
     auto lowerBound(int key) const -> ConstIt { return m_capts.lowerBound(key); }
-    auto insert(int key, const SubCapt &capt) -> It { return m_capts.insert(key, capt); }
+    auto data(ConstIt it) const -> QByteArray { return m_data.mid(it->offset, it->size); }
+    auto blocks(ConstIt it) const -> QList<RichTextBlock> { return decode(data(it)); }
+    auto document(ConstIt it) const -> RichTextDocument;
+    auto text(ConstIt it) const -> QString;
+    static auto encode(const QList<RichTextBlock> &blocks) -> QByteArray;
+    static auto decode(const QByteArray &data) -> QList<RichTextBlock>;
 
     auto name() const -> QString;
     auto fileName() const -> const QString& {return m_file;}
@@ -79,12 +87,32 @@ private:
     SubtitleFileInfo m_info;
     SyncType m_base = Time;
     Map m_capts;
+    QByteArray m_data;
     bool m_selection = false;
     int m_id = -1;
     SubType m_type = SubType::Unknown;
 };
 
-using SubtitleComponentIterator = QMapIterator<int, SubCapt>;
+// captions keyed by start time in ms for a frame rate. lookup moves from
+// position of previous one to its neighbor in O(1) during playback and
+// falls back to binary search on seek. component should stay unmodified.
+class SubCompCursor {
+public:
+    using Map = FlatMap<int, SubComp::ConstIt>;
+    using ConstIt = Map::const_iterator;
+    auto reset(const SubComp &comp, double fps) -> void;
+    auto isEmpty() const -> bool { return m_map.isEmpty(); }
+    auto begin() const -> ConstIt { return m_map.begin(); }
+    auto end() const -> ConstIt { return m_map.end(); }
+    // caption being shown at time or end()
+    auto start(int time) const -> ConstIt
+        { const auto it = finish(time); return it == begin() ? end() : it - 1; }
+    // first caption starting after time or end()
+    auto finish(int time) const -> ConstIt;
+private:
+    Map m_map;
+    mutable int m_upper = 0;
+};
 
 class Subtitle {
 public:
@@ -97,11 +125,14 @@ public:
     const QList<SubComp> &components() const { return m_comp; }
 //    auto start(int time, double frameRate) const -> int;
 //    auto end(int time, double frameRate) const -> int;
-    auto caption(int time, double frameRate) const -> RichTextDocument;
-    auto load(const QString &file, const QString &enc, double accuracy) -> bool;
+    // receives progress in [0, 1] while parsing and returns false to cancel
+    using Control = std::function<bool(double)>;
+    auto load(const QString &file, const QString &enc, double accuracy,
+              const Control &control = Control()) -> bool;
     auto clear() -> void {m_comp.clear();}
     auto append(const SubComp &comp) -> void {m_comp.append(comp);}
-    static auto parse(const QString &fileName, const QString &enc) -> Subtitle;
+    static auto parse(const QString &fileName, const QString &enc,
+                      const Control &control = Control()) -> Subtitle;
 private:
     friend class SubtitleParser;
     QList<SubComp> m_comp;
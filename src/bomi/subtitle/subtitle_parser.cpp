@@ -2,34 +2,122 @@
 
 int SubtitleParser::msPerChar = -1;
 
-auto SubtitleParser::parse(const QString &fileName,
-                           const QString &enc) -> Subtitle
+// enough to tell the format without decoding whole file again
+static constexpr int SniffSize = 4096;
+// characters parsed between progress reports
+static constexpr int ReportInterval = 64*1024;
+
+auto SubtitleParser::decode(const char *data, int size,
+                            const QString &enc) -> QString
+{
+    auto bytes = reinterpret_cast<const uchar*>(data);
+    auto utf16 = [&] (bool le, int skip) {
+        QString text((size - skip)/2, Qt::Uninitialized);
+        auto dst = text.data();
+        for (int i=0; i<text.size(); ++i, bytes += 2) {
+            dst[i] = le ? qFromLittleEndian<quint16>(bytes + skip)
+                        : qFromBigEndian<quint16>(bytes + skip);
+        }
+        return text;
+    };
+    // byte order mark precedes given encoding as QTextStream does
+    if (size >= 3 && bytes[0] == 0xef && bytes[1] == 0xbb && bytes[2] == 0xbf)
+        return QString::fromUtf8(data + 3, size - 3);
+    if (size >= 2 && bytes[0] == 0xff && bytes[1] == 0xfe)
+        return utf16(true, 2);
+    if (size >= 2 && bytes[0] == 0xfe && bytes[1] == 0xff)
+        return utf16(false, 2);
+    const auto name = enc.toUpper().remove('-'_q).remove('_'_q);
+    if (name == "UTF8"_a)
+        return QString::fromUtf8(data, size);
+    if (name == "UTF16LE"_a)
+        return utf16(true, 0);
+    if (name == "UTF16BE"_a)
+        return utf16(false, 0);
+    auto codec = QTextCodec::codecForName(enc.toLatin1());
+    if (!codec)
+        codec = QTextCodec::codecForLocale();
+    return codec->toUnicode(data, size);
+}
+
+auto SubtitleParser::sniff(const QFileInfo &file,
+                           const QStringRef &head) -> SubType
+{
+    const auto suffix = file.suffix().toLower();
+    if (_IsOneOf(suffix, "smi"_a, "sami"_a))
+        return SubType::SAMI;
+    if (suffix == "srt"_a)
+        return SubType::SubRip;
+    const auto text = head.trimmed();
+    if (text.startsWith("<sami"_a, QCI))
+        return SubType::SAMI;
+    if (text.startsWith('{'_q))
+        return SubType::MicroDVD;
+    if (!text.isEmpty() && text.at(0).isDigit())
+        return SubType::TMPlayer;
+    return SubType::Unknown;
+}
+
+auto SubtitleParser::parse(const QString &fileName, const QString &enc,
+                           const Control &control) -> Subtitle
 {
     QFile file(fileName);
-    if (!file.open(QFile::ReadOnly) || file.size() > (1 << 20))
+    if (!file.open(QFile::ReadOnly) || file.size() > _Max<int>())
+        return Subtitle();
+    QString all;
+    const int size = file.size();
+    if (auto data = file.map(0, size)) {
+        all = decode(reinterpret_cast<const char*>(data), size, enc);
+        file.unmap(data);
+    } else {
+        const auto bytes = file.readAll();
+        all = decode(bytes.constData(), bytes.size(), enc);
+    }
+    file.close();
+    if (control && !control(0.0))
         return Subtitle();
-    QTextStream in;
-    in.setDevice(&file);
-    in.setCodec(enc.toLocal8Bit());
-    const QString all = in.readAll();
     QFileInfo info(fileName);
     Subtitle sub;
+    bool canceled = false;
 
-    auto tryIt = [enc, &sub, &all, &info] (SubtitleParser *p) {
+    auto tryIt = [&] (SubtitleParser *p) {
         p->m_all = all;
         p->m_file = info;
         p->m_encoding = enc;
+        p->m_control = control;
         const bool parsable = p->isParsable();
         if (parsable)
             p->_parse(sub);
+        canceled = p->m_canceled;
         delete p;
         return parsable;
     };
 
-    if (tryIt(new SamiParser) || tryIt(new SubRipParser)
-            || tryIt(new MicroDVDParser) || tryIt(new TMPlayerParser))
-        return sub;
-    return Subtitle();
+    QList<SubtitleParser*> parsers;
+    parsers << new SamiParser << new SubRipParser
+            << new MicroDVDParser << new TMPlayerParser;
+    const auto type = sniff(info, all.leftRef(SniffSize));
+    std::stable_partition(parsers.begin(), parsers.end(),
+                          [type] (SubtitleParser *p) { return p->type() == type; });
+    bool parsed = false;
+    for (auto p : parsers) {
+        if (parsed)
+            delete p;
+        else
+            parsed = tryIt(p);
+    }
+    return parsed && !canceled ? sub : Subtitle();
+}
+
+auto SubtitleParser::isCanceled(int pos) const -> bool
+{
+    if (m_canceled)
+        return true;
+    if (!m_control || pos - m_reported < ReportInterval)
+        return false;
+    m_reported = pos;
+    m_canceled = !m_control(pos/(double)m_all.size());
+    return m_canceled;
 }
 
 auto SubtitleParser::processLine(int &idx, const QString &texts) -> QStringRef
@@ -60,10 +148,11 @@ auto SubtitleParser::predictEndTime(int start, const QStringRef &text) -> int
     return -1;
 }
 
-auto SubtitleParser::predictEndTime(const SubComp::const_iterator &it) -> int
+auto SubtitleParser::predictEndTime(const SubComp &comp,
+                                    const SubComp::const_iterator &it) -> int
 {
     if (msPerChar > 0)
-        return it.value().totalLength()*msPerChar + it.key();
+        return comp.text(it).size()*msPerChar + it.key();
     return -1;
 }
 
@@ -95,6 +184,10 @@ auto SubtitleParser::encodeEntity(const QStringRef &str) -> QString
 
 auto SubtitleParser::getLine() const -> QStringRef
 {
+    if (isCanceled(m_pos)) {
+        m_pos = m_all.size();
+        return QStringRef();
+    }
     int from = m_pos;
     int end = -1;
     while (m_pos < m_all.size()) {
@@ -6,7 +6,9 @@
 class SubtitleParser : public RichTextHelper {
 public:
     virtual ~SubtitleParser() {}
-    static auto parse(const QString &file, const QString &enc) -> Subtitle;
+    using Control = Subtitle::Control;
+    static auto parse(const QString &file, const QString &enc,
+                      const Control &control = Control()) -> Subtitle;
     static auto setMsPerCharactor(int msPerChar) -> void
         { SubtitleParser::msPerChar = msPerChar; }
 protected:
@@ -22,8 +24,11 @@ protected:
     auto skipSeparators() const -> bool
         { return RichTextHelper::skipSeparator(m_pos, m_all); }
     auto file() const -> const QFileInfo& { return m_file; }
+    // reports progress at pos from time to time and polls cancellation
+    auto isCanceled(int pos) const -> bool;
     auto append(Subtitle &s, SubComp::SyncType b = SubComp::Time) -> SubComp&;
-    static auto predictEndTime(const SubComp::const_iterator &it) -> int;
+    static auto predictEndTime(const SubComp &comp,
+                               const SubComp::const_iterator &it) -> int;
     static auto predictEndTime(int start, const QString &text) -> int;
     static auto predictEndTime(int start, const QStringRef &text) -> int;
     static auto encodeEntity(const QStringRef &str) -> QString;
@@ -33,14 +38,18 @@ protected:
     static auto components(const Subtitle &sub) -> const QList<SubComp>&
         { return sub.m_comp; }
     static auto append(SubComp &c, const QString &text, int start) -> void
-        { c[start] += RichTextDocument(text); }
+        { c.append(start, RichTextDocument(text).blocks()); }
     static auto append(SubComp &c, const QString &t, int start, int end) -> void
         { append(c, t, start); c[end]; }
 private:
+    static auto decode(const char *data, int size, const QString &enc) -> QString;
+    static auto sniff(const QFileInfo &file, const QStringRef &head) -> SubType;
     static int msPerChar;
     QString m_all, m_encoding;
     QFileInfo m_file;
-    mutable int m_pos = 0;
+    mutable int m_pos = 0, m_reported = 0;
+    mutable bool m_canceled = false;
+    Control m_control;
 };
 
 inline auto SubtitleParser::append(Subtitle &s, SubComp::SyncType b) -> SubComp&
@@ -37,6 +37,8 @@ auto SamiParser::_parse(Subtitle &sub) -> void
     RichTextBlockParser parser(text.midRef(pos));
     auto &comps = components(sub);
     while (!parser.atEnd()) {
+        if (isCanceled(pos + parser.pos()))
+            break;
         Tag tag;
         const auto block_sync = parser.get(u"sync"_q, u"/?sync|/body|/sami"_q,
                                            &tag);
@@ -61,7 +63,7 @@ auto SamiParser::_parse(Subtitle &sub) -> void
                 comp = &append(sub);
                 comp->setLanguage(it.key());
             }
-            (*comp)[sync] += it.value();
+            comp->append(sync, it.value());
         }
     }
 }
@@ -0,0 +1,266 @@
+#include "subtitleautoloader.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(Subtitle)
+
+enum EventType {
+    Watch = QEvent::User + 1, Done
+};
+
+// inotify watches are limited per user; cached listings are bound to this
+static constexpr int MaxWatches = 64;
+
+struct Listing {
+    QFileInfoList subtitles;
+    QStringList dirs;
+};
+
+class AutoloadTask : public QRunnable {
+public:
+    AutoloadTask(std::function<void(void)> &&func): m_func(std::move(func)) { }
+    auto run() -> void override { m_func(); }
+private:
+    std::function<void(void)> m_func;
+};
+
+struct SubtitleAutoloader::Job {
+    struct Result { QString file; Subtitle sub; bool ok = false; };
+    QString file;
+    Options options;
+    std::atomic<bool> canceled{false};
+    std::atomic<int> remaining{0};
+    std::vector<Result> results; // each one is written by a single task
+    bool wanted = false, done = false; // accessed in GUI thread only
+};
+
+struct SubtitleAutoloader::Data {
+    using JobPtr = QSharedPointer<Job>;
+    SubtitleAutoloader *p = nullptr;
+    QThreadPool pool;
+    QFileSystemWatcher watcher;
+    QMutex mutex;
+    QHash<QString, Listing> index;
+    QStringList watched; // oldest first
+    JobPtr job;
+    auto list(const QString &path) -> Listing;
+    auto scan(const JobPtr &job) -> void;
+    auto parse(const JobPtr &job, int idx) -> void;
+    auto start(const QString &file, const Options &options) -> Job*;
+    auto deliver() -> void;
+    auto watch(const QString &path, const QDateTime &modified) -> void;
+    auto drop(const QString &path) -> void;
+};
+
+auto SubtitleAutoloader::Options::operator == (const Options &rhs) const -> bool
+{
+    if (mode != rhs.mode || enc != rhs.enc || accuracy != rhs.accuracy
+            || paths.size() != rhs.paths.size())
+        return false;
+    for (int i = 0; i < paths.size(); ++i) {
+        auto &l = paths[i], &r = rhs.paths[i];
+        if (l.string() != r.string() || l.isRegEx() != r.isRegEx()
+                || l.isCaseSensitive() != r.isCaseSensitive())
+            return false;
+    }
+    return true;
+}
+
+auto SubtitleAutoloader::Data::list(const QString &path) -> Listing
+{
+    mutex.lock();
+    auto it = index.constFind(path);
+    if (it != index.cend()) {
+        const auto listing = *it;
+        mutex.unlock();
+        return listing;
+    }
+    mutex.unlock();
+
+    Listing listing;
+    const QFileInfo info(path);
+    if (!info.isDir())
+        return listing;
+    static const auto filter = _ToNameFilter(SubtitleExt);
+    const QDir dir(path);
+    listing.subtitles = dir.entryInfoList(filter, QDir::Files, QDir::Name);
+    listing.dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    mutex.lock();
+    index.insert(path, listing);
+    mutex.unlock();
+    // changes before watch is installed are caught by modification time
+    _PostEvent(p, Watch, path, info.lastModified());
+    return listing;
+}
+
+auto SubtitleAutoloader::Data::scan(const JobPtr &job) -> void
+{
+    const QFileInfo info(job->file);
+    const auto base = info.completeBaseName();
+    const auto root = info.absolutePath();
+    const auto top = list(root);
+    QStringList dirs;
+    for (auto &path : job->options.paths) {
+        for (auto &one : top.dirs) {
+            if (path.match(one))
+                dirs.push_back(root % '/'_q % one);
+        }
+    }
+    const auto mode = job->options.mode;
+    auto collect = [&] (const QFileInfoList &all) {
+        for (auto &file : all) {
+            if (mode != SubtitleAutoload::Folder) {
+                if (mode == SubtitleAutoload::Matched) {
+                    if (base != file.completeBaseName())
+                        continue;
+                } else if (!file.fileName().contains(base))
+                    continue;
+            }
+            job->results.emplace_back();
+            job->results.back().file = file.absoluteFilePath();
+        }
+    };
+    collect(top.subtitles);
+    for (int i = 0; i < dirs.size() && !job->canceled; ++i)
+        collect(list(dirs[i]).subtitles);
+
+    const int count = job->results.size();
+    if (!count || job->canceled) {
+        _PostEvent(p, Done, job);
+        return;
+    }
+    job->remaining = count;
+    for (int i = 1; i < count; ++i)
+        pool.start(new AutoloadTask([this, job, i] () { parse(job, i); }));
+    parse(job, 0);
+}
+
+auto SubtitleAutoloader::Data::parse(const JobPtr &job, int idx) -> void
+{
+    auto &result = job->results[idx];
+    if (!job->canceled) {
+        auto control = [&] (double) { return !job->canceled; };
+        result.ok = result.sub.load(result.file, job->options.enc,
+                                    job->options.accuracy, control);
+    }
+    if (--job->remaining == 0)
+        _PostEvent(p, Done, job);
+}
+
+auto SubtitleAutoloader::Data::start(const QString &file,
+                                     const Options &options) -> Job*
+{
+    if (job && job->file == file && job->options == options)
+        return job.data();
+    if (job)
+        job->canceled = true;
+    job = JobPtr::create();
+    job->file = file;
+    job->options = options;
+    const auto copy = job;
+    pool.start(new AutoloadTask([this, copy] () { scan(copy); }));
+    return job.data();
+}
+
+auto SubtitleAutoloader::Data::deliver() -> void
+{
+    const auto done = job;
+    job.reset();
+    QVector<SubComp> loaded;
+    QStringList failed;
+    for (auto &result : done->results) {
+        if (result.ok) {
+            for (int i = 0; i < result.sub.size(); ++i)
+                loaded.push_back(result.sub[i]);
+        } else
+            failed.push_back(result.file);
+    }
+    emit p->finished(done->file, loaded, failed, done->options.enc);
+}
+
+auto SubtitleAutoloader::Data::watch(const QString &path,
+                                     const QDateTime &modified) -> void
+{
+    if (watched.contains(path))
+        return;
+    if (QFileInfo(path).lastModified() != modified)
+        return drop(path);
+    if (watched.size() >= MaxWatches)
+        drop(watched.first());
+    if (!watcher.addPath(path)) {
+        _Debug("Cannot watch %%. Listing will not be cached.", path);
+        return drop(path);
+    }
+    watched.push_back(path);
+}
+
+auto SubtitleAutoloader::Data::drop(const QString &path) -> void
+{
+    mutex.lock();
+    index.remove(path);
+    mutex.unlock();
+    if (watched.removeOne(path))
+        watcher.removePath(path);
+}
+
+SubtitleAutoloader::SubtitleAutoloader(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    d->p = this;
+    d->pool.setMaxThreadCount(2);
+    connect(&d->watcher, &QFileSystemWatcher::directoryChanged,
+            this, [this] (const QString &path) { d->drop(path); });
+}
+
+SubtitleAutoloader::~SubtitleAutoloader()
+{
+    cancel();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto SubtitleAutoloader::prefetch(const QString &file,
+                                  const Options &options) -> void
+{
+    d->start(file, options);
+}
+
+auto SubtitleAutoloader::request(const QString &file,
+                                 const Options &options) -> void
+{
+    auto job = d->start(file, options);
+    job->wanted = true;
+    if (job->done)
+        d->deliver();
+}
+
+auto SubtitleAutoloader::cancel() -> void
+{
+    if (d->job) {
+        d->job->canceled = true;
+        d->job.reset();
+    }
+}
+
+auto SubtitleAutoloader::customEvent(QEvent *event) -> void
+{
+    switch ((int)event->type()) {
+    case Watch: {
+        QString path; QDateTime modified;
+        _TakeData(event, path, modified);
+        d->watch(path, modified);
+        break;
+    } case Done: {
+        QSharedPointer<Job> job;
+        _TakeData(event, job);
+        if (job != d->job)
+            break; // canceled or replaced
+        job->done = true;
+        if (job->wanted)
+            d->deliver();
+        break;
+    } default:
+        QObject::customEvent(event);
+        break;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef SUBTITLEAUTOLOADER_HPP
+#define SUBTITLEAUTOLOADER_HPP
+
+#include "subtitle.hpp"
+#include "enum/subtitleautoload.hpp"
+#include "misc/matchstring.hpp"
+
+// finds subtitles beside a media file and in its search subdirectories and
+// parses them on a small thread pool so that playback is not held back.
+// listings of directories are cached until file system watcher reports
+// changes in them. signals are emitted in the thread where autoloader lives.
+class SubtitleAutoloader : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        SubtitleAutoload mode = SubtitleAutoload::Matched;
+        QString enc;
+        double accuracy = -1.0; // < 0 disables charset detection
+        QList<MatchString> paths;
+        auto operator == (const Options &rhs) const -> bool;
+    };
+    SubtitleAutoloader(QObject *parent = nullptr);
+    ~SubtitleAutoloader();
+    // starts loading in background without emitting the result
+    auto prefetch(const QString &file, const Options &options) -> void;
+    // emits finished() once loading started by prefetch() or here is done
+    auto request(const QString &file, const Options &options) -> void;
+    auto cancel() -> void;
+signals:
+    void finished(const QString &file, const QVector<SubComp> &loaded,
+                  const QStringList &failed, const QString &enc);
+private:
+    auto customEvent(QEvent *event) -> void override;
+    struct Job;
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLEAUTOLOADER_HPP
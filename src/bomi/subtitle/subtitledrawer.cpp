@@ -1,12 +1,14 @@
 #include "subtitledrawer.hpp"
+#include <functional>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 SubCompImage::SubCompImage(const SubComp *comp, Iterator it, void *creator)
     : m_comp(comp)
     , m_it(it)
     , m_creator(creator)
 {
-    if (m_it != comp->end())
-        m_text = *m_it;
 }
 
 SubCompImage::SubCompImage(const SubComp *comp)
@@ -18,6 +20,212 @@ SubCompImage::SubCompImage(const SubComp *comp)
 
 /******************************************************************************/
 
+// below this size, handing bands to other threads costs more than it saves
+static constexpr int ParallelPixels = 1024*1024;
+static constexpr int MinBandRows = 64;
+
+class BandTask : public QRunnable {
+public:
+    BandTask(std::function<void(void)> &&run, QSemaphore *done)
+        : m_run(std::move(run)), m_done(done) { }
+    auto run() -> void override { m_run(); m_done->release(); }
+private:
+    std::function<void(void)> m_run;
+    QSemaphore *m_done = nullptr;
+};
+
+template<class F>
+static auto forBands(const QSize &size, F func) -> void
+{
+    const int rows = size.height();
+    int bands = 1;
+    if (size.width() * rows >= ParallelPixels)
+        bands = qBound(1, QThread::idealThreadCount(), rows / MinBandRows);
+    if (bands < 2)
+        return func(0, rows);
+    const int step = (rows + bands - 1) / bands;
+    QSemaphore done;
+    int queued = 0;
+    for (int from = step; from < rows; from += step, ++queued) {
+        const int to = qMin(rows, from + step);
+        QThreadPool::globalInstance()->start(new BandTask([=] () {
+            func(from, to);
+        }, &done));
+    }
+    func(0, step);
+    done.acquire(queued);
+}
+
+auto FastAlphaBlur::setSize(const QSize &size) -> void
+{
+    if (size != s) {
+        s = size;
+        if (!s.isEmpty()) {
+            xin.resize(s.width());
+            xout.resize(s.width());
+            yin.resize(s.height());
+            yout.resize(s.height());
+            valpha.resize(s.width()*s.height());
+        }
+    }
+}
+
+auto FastAlphaBlur::setRadius(int radius) -> void
+{
+    if (this->radius != radius) {
+        this->radius = radius;
+        if (radius > 0) {
+            const int range = (radius << 1) + 1;
+            vinv.resize(range << 8);
+            for (int i=0; i<vinv.size(); ++i)
+                vinv[i] = i/range;
+        }
+    }
+}
+
+auto FastAlphaBlur::applyTo(QImage &mask, const QColor &color,
+                            int radius) -> void
+{
+    if (radius < 1 || mask.isNull())
+        return;
+    setSize(mask.size());
+    setRadius(radius);
+    const int w = s.width(), h = s.height();
+    for (int x=0; x<w; ++x) {
+        xin[x] = qMin(x + radius + 1, w - 1);
+        xout[x] = qMax(x - radius, 0);
+    }
+    for (int y=0; y<h; ++y) {
+        yin[y] = qMin(y + radius + 1, h - 1)*w;
+        yout[y] = qMax(y - radius, 0)*w;
+    }
+    // premultiplied pixel for each blurred alpha
+    vcolor.resize(256);
+    const double r = color.redF(), g = color.greenF(), b = color.blueF();
+    for (int a=0; a<256; ++a) {
+        vcolor[a] = quint32(a) << 24 | quint32(uchar(a*r)) << 16
+                | quint32(uchar(a*g)) << 8 | quint32(uchar(a*b));
+    }
+    uchar *alpha = valpha.data();
+    forBands(s, [&] (int from, int to) { blurRows(mask, alpha, from, to); });
+    forBands(s, [&] (int from, int to) { blurColumns(mask, from, to); });
+}
+
+auto FastAlphaBlur::blurRows(const QImage &mask, uchar *alpha,
+                             int from, int to) const -> void
+{
+    const int w = s.width(), xmax = w - 1;
+    const uchar *inv = vinv.constData();
+    const int *in = xin.constData(), *out = xout.constData();
+    for (int y=from; y<to; ++y) {
+        const uchar *c_bits = mask.constScanLine(y) + 3;
+        uchar *it = alpha + y*w;
+        int sum = 0;
+        for (int i=-radius; i<=radius; ++i)
+            sum += c_bits[qBound(0, i, xmax) << 2];
+        for (int x=0; x<w; ++x) {
+            sum += c_bits[in[x] << 2];
+            sum -= c_bits[out[x] << 2];
+            it[x] = inv[sum];
+        }
+    }
+}
+
+// sums[x] += in[x] - out[x] for a whole row
+static auto slide(int *sums, const uchar *in, const uchar *out, int w) -> void
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= w; x += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+        const __m128i diff[2] = {
+            _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+            _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero))
+        };
+        auto dst = reinterpret_cast<__m128i*>(sums + x);
+        for (int i=0; i<2; ++i) {
+            // sign-extend 16 bit differences to 32 bit
+            const auto sign = _mm_cmplt_epi16(diff[i], zero);
+            const auto lo = _mm_unpacklo_epi16(diff[i], sign);
+            const auto hi = _mm_unpackhi_epi16(diff[i], sign);
+            _mm_storeu_si128(dst + i*2, _mm_add_epi32(_mm_loadu_si128(dst + i*2), lo));
+            _mm_storeu_si128(dst + i*2 + 1, _mm_add_epi32(_mm_loadu_si128(dst + i*2 + 1), hi));
+        }
+    }
+#endif
+    for (; x<w; ++x)
+        sums[x] += in[x] - out[x];
+}
+
+auto FastAlphaBlur::blurColumns(QImage &mask, int from, int to) const -> void
+{
+    const int w = s.width(), ymax = s.height() - 1;
+    const uchar *alpha = valpha.constData(), *inv = vinv.constData();
+    const quint32 *colors = vcolor.constData();
+    QVector<int> buffer(w, 0);
+    int *sums = buffer.data();
+    for (int i=-radius; i<=radius; ++i) {
+        const uchar *row = alpha + qBound(0, from + i, ymax)*w;
+        for (int x=0; x<w; ++x)
+            sums[x] += row[x];
+    }
+    for (int y=from; y<to; ++y) {
+        auto p = reinterpret_cast<quint32*>(mask.scanLine(y));
+        for (int x=0; x<w; ++x) {
+            if ((p[x] >> 24) < 255)
+                p[x] = colors[inv[sums[x]]];
+        }
+        slide(sums, alpha + yin[y], alpha + yout[y], w);
+    }
+}
+
+// fill shadow with premultiplied color scaled by alpha of image at offset
+static auto castShadow(QImage &shadow, const QImage &image,
+                       const QPoint &offset, const QColor &color) -> void
+{
+    const int w = shadow.width(), h = shadow.height();
+    const int ox = qMin(offset.x(), w);
+    const quint32 sa = color.alpha();
+    // (alpha*k) >> 16 for each channel in memory order of ARGB32
+    const quint16 k[4] = { quint16(color.blue()*sa), quint16(color.green()*sa),
+                           quint16(color.red()*sa), quint16(sa << 8) };
+    for (int y=0; y<h; ++y) {
+        auto dst = reinterpret_cast<quint32*>(shadow.scanLine(y));
+        const int ys = y - offset.y();
+        if (ys < 0) {
+            memset(dst, 0, w*4);
+            continue;
+        }
+        memset(dst, 0, ox*4);
+        dst += ox;
+        auto src = reinterpret_cast<const quint32*>(image.constScanLine(ys));
+        const int len = w - ox;
+        int x = 0;
+#ifdef __SSE2__
+        const auto coef = _mm_setr_epi16(k[0], k[1], k[2], k[3],
+                                         k[0], k[1], k[2], k[3]);
+        for (; x + 4 <= len; x += 4) {
+            auto a = _mm_srli_epi32(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + x)), 24);
+            a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+            const auto lo = _mm_mulhi_epu16(_mm_unpacklo_epi32(a, a), coef);
+            const auto hi = _mm_mulhi_epu16(_mm_unpackhi_epi32(a, a), coef);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                             _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x<len; ++x) {
+            const quint32 a = src[x] >> 24;
+            dst[x] = (a*k[3] >> 16) << 24 | (a*k[2] >> 16) << 16
+                    | (a*k[1] >> 16) << 8 | (a*k[0] >> 16);
+        }
+    }
+}
+
+/******************************************************************************/
+
 auto SubtitleDrawer::pos(const QSizeF &img, const QRectF &area) const -> QPointF
 {
     QPointF pos(0.0, 0.0);
@@ -42,8 +250,82 @@ auto SubtitleDrawer::pos(const QSizeF &img, const QRectF &area) const -> QPointF
     return pos;
 }
 
+/******************************************************************************/
+
+// Laid out documents for a caption shared by all drawers. Layout is done in
+// document unit so that it survives resizing unless wrap width changes.
+struct SubtitleLayout {
+    QMutex mutex; // QTextLayout is not thread-safe
+    RichTextDocument front, back;
+    bool ready = false;
+};
+
+// caption is identified by its serialized blocks
+struct SubtitleLayoutKey {
+    QByteArray caption; quint64 style; double width;
+    auto operator == (const SubtitleLayoutKey &rhs) const -> bool
+    {
+        return caption == rhs.caption && style == rhs.style
+                && width == rhs.width;
+    }
+};
+
+static auto qHash(const SubtitleLayoutKey &key, uint seed = 0) -> uint
+{
+    return ::qHash(key.caption, seed) ^ ::qHash(key.style, seed)
+            ^ ::qHash(qRound64(key.width * 16), seed);
+}
+
+static constexpr int LayoutCacheSize = 128;
+
+class SubtitleLayoutCache {
+public:
+    auto get(const QByteArray &caption, quint64 style,
+             double width) -> QSharedPointer<SubtitleLayout>
+    {
+        const SubtitleLayoutKey key{ caption, style, width };
+        QMutexLocker locker(&m_mutex);
+        auto &entry = m_entries[key];
+        entry.used = ++m_clock;
+        if (!entry.layout) {
+            entry.layout.reset(new SubtitleLayout);
+            if (m_entries.size() > LayoutCacheSize)
+                evict();
+        }
+        return entry.layout;
+    }
+private:
+    auto evict() -> void
+    {
+        auto victim = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->used < victim->used)
+                victim = it;
+        }
+        m_entries.erase(victim);
+    }
+    struct Entry {
+        QSharedPointer<SubtitleLayout> layout;
+        quint64 used = 0;
+    };
+    QMutex m_mutex;
+    QHash<SubtitleLayoutKey, Entry> m_entries;
+    quint64 m_clock = 0;
+};
+
+static SubtitleLayoutCache layouts;
+static std::atomic<quint64> styleIds{0};
+
+auto SubtitleDrawer::setAlignment(Qt::Alignment alignment) -> void
+{
+    m_back.setAlignment(m_alignment = alignment);
+    m_front.setAlignment(alignment);
+    m_styleId = ++styleIds;
+}
+
 auto SubtitleDrawer::setStyle(const OsdStyle &style) -> void
 {
+    m_styleId = ++styleIds;
     m_style = style;
     updateStyle(m_front, style);
     updateStyle(m_back, style);
@@ -56,22 +338,37 @@ auto SubtitleDrawer::setStyle(const OsdStyle &style) -> void
 
 auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
                           const QRectF &area, double dpr) -> QVector<QRectF>
+{
+    const bool words = text.hasWords();
+    return draw(image, gap, words ? SubComp::encode(text.blocks()) : QByteArray(),
+                area, dpr);
+}
+
+auto SubtitleDrawer::draw(QImage &image, int &gap, const QByteArray &caption,
+                          const QRectF &area, double dpr) -> QVector<QRectF>
 {
     QVector<QRectF> bboxes;
     gap = 0;
-    if (!(m_drawn = text.hasWords()))
+    if (!(m_drawn = !caption.isEmpty()))
         return bboxes;
     const double scale = this->scale(area)*dpr;
     const double fscale = m_style.font.height()*scale;
-    auto make = [=] (RichTextDocument &doc, const RichTextDocument &from) {
-        doc = from;
-        doc += text;
-        doc.updateLayoutInfo();
-        doc.doLayout(area.width()/(scale/dpr));
-    };
-    RichTextDocument front, back;
-    make(front, m_front);
-    make(back, m_back);
+    const double width = area.width()/(scale/dpr);
+    auto layout = layouts.get(caption, m_styleId, width);
+    QMutexLocker locker(&layout->mutex);
+    auto &front = layout->front, &back = layout->back;
+    if (!layout->ready) {
+        const auto text = SubComp::decode(caption);
+        auto make = [&] (RichTextDocument &doc, const RichTextDocument &from) {
+            doc = from;
+            doc += text;
+            doc.updateLayoutInfo();
+            doc.doLayout(width);
+        };
+        make(front, m_front);
+        make(back, m_back);
+        layout->ready = true;
+    }
     QPoint thick(0, 0);
     if (m_style.bbox.enabled)
         thick = (fscale*m_style.bbox.padding).toPoint();
@@ -110,35 +407,7 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
         if (m_style.shadow.enabled) {
             QImage bg(image.size(), QImage::Format_ARGB32_Premultiplied);
             bg.setDevicePixelRatio(dpr);
-            auto dest = bg.bits();
-            const quint32 sr = m_style.shadow.color.red();
-            const quint32 sg = m_style.shadow.color.green();
-            const quint32 sb = m_style.shadow.color.blue();
-            const quint32 sa = m_style.shadow.color.alpha();
-            for (int y=0; y<bg.height(); ++y) {
-                const int ys = y - soffset.y();
-                if (ys < 0) {
-                    memset(dest, 0, bg.bytesPerLine());
-                    dest += bg.bytesPerLine();
-                } else {
-                    auto src = image.bits() + image.bytesPerLine() * ys;
-                    for (int x=0; x<bg.width(); ++x) {
-                        const int xs = x-soffset.x();
-                        if (xs < 0) {
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                        } else {
-                            *dest++ = sb*sa*src[3] >> 16;
-                            *dest++ = sg*sa*src[3] >> 16;
-                            *dest++ = sr*sa*src[3] >> 16;
-                            *dest++ = sa*   src[3] >> 8;
-                            src += 4;
-                        }
-                    }
-                }
-            }
+            castShadow(bg, image, soffset, m_style.shadow.color);
             if (blur)
                 m_blur.applyTo(bg, m_style.shadow.color, blur);
             painter.begin(&bg);
@@ -13,99 +13,21 @@ struct Margin {
 
 class FastAlphaBlur {
 public:
-    FastAlphaBlur(): radius(-1) {}
-    // copied from openframeworks superfast blur and modified
-    auto applyTo(QImage &mask, const QColor &color, int radius) -> void {
-        if (radius < 1 || mask.isNull())
-            return;
-        setSize(mask.size());
-        setRadius(radius);
-        const int w = s.width();
-        const int h = s.height();
-
-        uchar *a = valpha.data();
-        const uchar *inv = vinv.constData();
-        int *min = vmin.data();
-        int *max = vmax.data();
-
-        const int xmax = mask.width()-1;
-        for (int x=0; x<w; ++x) {
-            min[x] = qMin(x + radius + 1, xmax);
-            max[x] = qMax(x - radius, 0);
-        }
-
-        const uchar *c_bits = mask.constBits()+3;
-        uchar *it = a;
-        for (int y=0; y<h; ++y, c_bits += (mask.width() << 2)) {
-            int sum = 0;
-            for(int i=-radius; i<=radius; ++i)
-                sum += c_bits[qBound(0, i, xmax) << 2];
-            for (int x=0; x<w; ++x, ++it) {
-                sum += c_bits[min[x] << 2];
-                sum -= c_bits[max[x] << 2];
-                *it = inv[sum];
-            }
-        }
-
-        const int ymax = mask.height()-1;
-        for (int y=0; y<h; ++y){
-            min[y] = qMin(y + radius + 1, ymax)*w;
-            max[y] = qMax(y - radius, 0)*w;
-        }
-
-        uchar *bits = mask.bits();
-        const double r = color.redF();
-        const double g = color.greenF();
-        const double b = color.blueF();
-        const uchar *c_it = a;
-        for (int x=0; x<w; ++x, ++c_it){
-            int sum = 0;
-            int yp = -radius*w;
-            for(int i=-radius; i<=radius; ++i, yp += w)
-                sum += c_it[qMax(0, yp)];
-            uchar *p = bits + (x << 2);
-            for (int y=0; y<h; ++y, p += (xmax << 2)){
-                const uchar a = inv[sum];
-                if (p[3] < 255) {
-                    *p++ = a*b;
-                    *p++ = a*g;
-                    *p++ = a*r;
-                    *p++ = a;
-                } else {
-                    p += 4;
-                }
-                sum += c_it[min[y]];
-                sum -= c_it[max[y]];
-            }
-        }
-    }
-
+    // originally from openframeworks superfast blur. both passes walk rows
+    // and large images are split into bands blurred in parallel
+    auto applyTo(QImage &mask, const QColor &color, int radius) -> void;
 private:
-    auto setSize(const QSize &size) -> void {
-        if (size != s) {
-            s = size;
-            if (!s.isEmpty()) {
-                vmin.resize(qMax(s.width(), s.height()));
-                vmax.resize(vmin.size());
-                valpha.resize(s.width()*s.height());
-            }
-        }
-    }
-    auto setRadius(const int radius) -> void {
-        if (this->radius != radius) {
-            this->radius = radius;
-            if (radius > 0) {
-                const int range = (radius << 1) + 1;
-                vinv.resize(range << 8);
-                for (int i=0; i<vinv.size(); ++i)
-                    vinv[i] = i/range;
-            }
-        }
-    }
-    int radius;
+    auto blurRows(const QImage &mask, uchar *alpha, int from, int to) const
+        -> void;
+    auto blurColumns(QImage &mask, int from, int to) const -> void;
+    auto setSize(const QSize &size) -> void;
+    auto setRadius(int radius) -> void;
+    int radius = -1;
     QSize s;
-    QVector<int> vmin, vmax;
+    // source index entering and leaving running window for each x and y
+    QVector<int> xin, xout, yin, yout;
     QVector<uchar> valpha, vinv;
+    QVector<quint32> vcolor;
 };
 
 class SubCompImage : public QImage {
@@ -114,7 +36,8 @@ public:
     SubCompImage(const SubComp *comp, Iterator it, void *creator);
     SubCompImage(const SubComp *comp);
     auto iterator() const -> Iterator { return m_it; }
-    auto text() const -> const RichTextDocument& { return m_text; }
+    auto text() const -> RichTextDocument
+        { return isValid() ? m_comp->document(m_it) : RichTextDocument(); }
     auto component() const -> const SubComp* { return m_comp; }
     auto layoutSize() const -> QSize { return size()/devicePixelRatio(); }
     auto isValid() const -> bool { return m_comp && m_it != m_comp->end(); }
@@ -125,7 +48,6 @@ private:
     friend class SubtitleDrawer;
     const SubComp *m_comp = nullptr;
     Iterator m_it;
-    RichTextDocument m_text;
     QVector<QRectF> m_bboxes;
     int m_gap = 0;
     void *m_creator = nullptr;
@@ -146,27 +68,27 @@ public:
     auto style() const -> const OsdStyle& {return m_style;}
     auto scale(const QRectF &area) const -> double;
 private:
+    // caption is serialized blocks or empty if it has no words
+    auto draw(QImage &image, int &gap, const QByteArray &caption,
+              const QRectF &area, double dpr) -> QVector<QRectF>;
     static auto updateStyle(RichTextDocument &doc,
                             const OsdStyle &style) -> void;
     OsdStyle m_style;
     RichTextDocument m_front, m_back;
     Margin m_margin;
     Qt::Alignment m_alignment;
+    quint64 m_styleId = 0; // identifies layout affecting options
     bool m_drawn = false;
     FastAlphaBlur m_blur;
     QByteArray m_buffer;
 };
 
-inline auto SubtitleDrawer::setAlignment(Qt::Alignment alignment) -> void
-{
-    m_back.setAlignment(m_alignment = alignment);
-    m_front.setAlignment(alignment);
-}
-
 inline auto SubtitleDrawer::draw(SubCompImage &pic, const QRectF &area,
                                  double dpr) -> bool
 {
-    pic.m_bboxes = draw(pic, pic.m_gap, pic.m_text, area, dpr);
+    const bool words = pic.isValid() && pic.m_it->hasWords();
+    const auto caption = words ? pic.m_comp->data(pic.m_it) : QByteArray();
+    pic.m_bboxes = draw(pic, pic.m_gap, caption, area, dpr);
     return !pic.isNull();
 }
 
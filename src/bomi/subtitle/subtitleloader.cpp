@@ -0,0 +1,126 @@
+#include "subtitleloader.hpp"
+#include "subtitle.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(Subtitle)
+
+enum EventType {
+    Progress = QEvent::User + 1, Loaded, Failed
+};
+
+// do not flood event loop with progress of fast parsing
+static constexpr int ProgressInterval = 100;
+
+struct SubtitleLoader::Data {
+    struct Request {
+        QString file, enc;
+        double accuracy = -1.0;
+        bool select = false;
+        int generation = 0;
+    };
+    QMutex mutex;
+    QList<Request> queue;
+    // bumped by cancel(); requests and events of older one are stale
+    std::atomic<int> generation{0};
+    auto isStale(int gen) const -> bool { return gen != generation; }
+};
+
+SubtitleLoader::SubtitleLoader(QObject *parent)
+    : QThread(parent), d(new Data)
+{
+    connect(this, &QThread::finished, this, [this] () {
+        d->mutex.lock();
+        const bool pending = !d->queue.isEmpty();
+        d->mutex.unlock();
+        if (pending)
+            start();
+    });
+}
+
+SubtitleLoader::~SubtitleLoader()
+{
+    cancel();
+    wait();
+    delete d;
+}
+
+auto SubtitleLoader::load(const QStringList &files, const QString &enc,
+                          double accuracy, bool select) -> void
+{
+    d->mutex.lock();
+    for (auto &file : files)
+        d->queue.push_back({ file, enc, accuracy, select, d->generation });
+    d->mutex.unlock();
+    if (!isRunning())
+        start();
+}
+
+auto SubtitleLoader::cancel() -> void
+{
+    d->mutex.lock();
+    d->queue.clear();
+    ++d->generation;
+    d->mutex.unlock();
+    qApp->removePostedEvents(this);
+}
+
+auto SubtitleLoader::run() -> void
+{
+    for (;;) {
+        d->mutex.lock();
+        if (d->queue.isEmpty()) {
+            d->mutex.unlock();
+            break;
+        }
+        const auto req = d->queue.takeFirst();
+        d->mutex.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        const int gen = req.generation;
+        auto control = [&] (double rate) {
+            if (timer.elapsed() >= ProgressInterval) {
+                _PostEvent(this, Progress, gen, req.file, rate);
+                timer.restart();
+            }
+            return !d->isStale(gen);
+        };
+        Subtitle sub;
+        const bool loaded = sub.load(req.file, req.enc, req.accuracy, control);
+        if (d->isStale(gen))
+            _Debug("Loading %% canceled.", req.file);
+        else if (loaded)
+            _PostEvent(this, Loaded, gen, sub, req.select);
+        else
+            _PostEvent(this, Failed, gen, req.file, req.enc);
+    }
+}
+
+auto SubtitleLoader::customEvent(QEvent *event) -> void
+{
+    // cancel() may have been called after event was posted
+    switch ((int)event->type()) {
+    case Progress: {
+        int gen = 0; QString file; double rate = 0;
+        _TakeData(event, gen, file, rate);
+        if (!d->isStale(gen))
+            emit progress(file, rate);
+        break;
+    } case Loaded: {
+        int gen = 0; Subtitle sub; bool select = false;
+        _TakeData(event, gen, sub, select);
+        if (!d->isStale(gen))
+            emit loaded(sub, select);
+        break;
+    } case Failed: {
+        int gen = 0; QString file, enc;
+        _TakeData(event, gen, file, enc);
+        if (!d->isStale(gen))
+            emit failed(file, enc);
+        break;
+    } default:
+        QThread::customEvent(event);
+        break;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef SUBTITLELOADER_HPP
+#define SUBTITLELOADER_HPP
+
+class Subtitle;
+
+// detects charset and parses subtitle files one by one off the GUI thread.
+// signals are emitted in the thread where loader lives.
+class SubtitleLoader : public QThread {
+    Q_OBJECT
+public:
+    SubtitleLoader(QObject *parent = nullptr);
+    ~SubtitleLoader();
+    // accuracy < 0 disables charset detection
+    auto load(const QStringList &files, const QString &enc,
+              double accuracy, bool select) -> void;
+    auto cancel() -> void;
+signals:
+    void progress(const QString &file, double rate);
+    void loaded(const Subtitle &sub, bool select);
+    void failed(const QString &file, const QString &enc);
+private:
+    auto run() -> void override;
+    auto customEvent(QEvent *event) -> void override;
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLELOADER_HPP
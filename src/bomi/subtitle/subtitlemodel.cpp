@@ -54,7 +54,7 @@ auto SubCompModel::displayData(int row, int column) const -> QVariant
     switch (column) {
     case Start: return _MSecToString(data.start());
     case End:   return _MSecToString(data.end());
-    case Text:  return data.m_it->toPlainText();
+    case Text:  return d->comp->text(data.m_it);
     default:    return QVariant();
     }
 }
@@ -1,8 +1,11 @@
 #include "subtitlerendereritem.hpp"
 #include "subtitlerenderingthread.hpp"
+#include "subtitlesearchindex.hpp"
 #include "misc/dataevent.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/opengltexturepool.hpp"
+#include "opengl/opengltextureuploader.hpp"
 
 struct SubtitleShaderData : public SubtitleRendererItem::ShaderData {
     const OpenGLTexture2D *texture, *bbox;
@@ -53,6 +56,21 @@ private:
     int loc_tex = -1, loc_bbox = -1, loc_bboxColor = -1;
 };
 
+auto reg_subtitle_renderer_item() -> void { qmlRegisterType<SubtitleRendererItem>(); }
+
+static constexpr int IndexBuilt = SubCompSelection::CursorBuilt + 1;
+
+class IndexTask : public QRunnable {
+public:
+    IndexTask(std::function<void(void)> &&func): m_func(std::move(func)) { }
+    auto run() -> void override { m_func(); }
+private:
+    std::function<void(void)> m_func;
+};
+
+using IndexFlag = QSharedPointer<std::atomic<bool>>;
+using IndexPtr = QSharedPointer<SubtitleSearchIndex>;
+
 struct SubtitleRendererItem::Data {
     Data(SubtitleRendererItem *p): p(p) {}
     SubtitleRendererItem *p = nullptr;
@@ -71,9 +89,12 @@ struct SubtitleRendererItem::Data {
 //        return langMap.value(r->comp->language().id(), -1);
         return langMap.value(comp.language(), -1);
     }
-    QVector<quint32> zeros, bboxData;
     SubCompSelection selection{p};
     OpenGLTexture2D bbox;
+    OpenGLTextureUploader uploader;
+    // images and where they are in texture as of last upload
+    struct Placed { QImage image; QRect rect; QVector<QRectF> bboxes; };
+    QVector<Placed> placed;
     double fps() const { return selection.fps(); }
     void updateDrawer() {
         selection.setDrawer(drawer);
@@ -104,18 +125,38 @@ struct SubtitleRendererItem::Data {
     void updateVisible() {
         p->setVisible(!hidden && !empty && !imageSize.isEmpty());
     }
+    // search indexes are built off GUI thread while component is loaded
+    QThreadPool indexer;
+    QHash<const SubComp*, IndexPtr> indexes;
+    IndexFlag indexCanceled = IndexFlag::create(false);
+    void index(const SubComp *comp) {
+        const auto canceled = indexCanceled;
+        const auto copy = *comp;
+        indexer.start(new IndexTask([=] () {
+            auto index = IndexPtr::create();
+            if (index->build(copy, [&] () { return canceled->load(); }))
+                _PostEvent(p, IndexBuilt, canceled, comp, index);
+        }));
+    }
+    void cancelIndexing() {
+        *indexCanceled = true;
+        indexCanceled = IndexFlag::create(false);
+        indexes.clear();
+    }
 };
 
 SubtitleRendererItem::SubtitleRendererItem(QQuickItem *parent)
     : SimpleTextureItem(parent)
     , d(new Data(this))
 {
+    d->indexer.setMaxThreadCount(1);
     d->drawer.setAlignment(Qt::AlignBottom | Qt::AlignHCenter);
     d->updateDrawer();
 }
 
 SubtitleRendererItem::~SubtitleRendererItem() {
     unload();
+    d->indexer.waitForDone();
     delete d;
 }
 
@@ -143,15 +184,18 @@ auto SubtitleRendererItem::createShader() const -> ShaderIface*
 auto SubtitleRendererItem::initializeGL() -> void
 {
     SimpleTextureItem::initializeGL();
-    texture().create();
-    d->bbox.create();
+    d->uploader.create();
 }
 
 auto SubtitleRendererItem::finalizeGL() -> void
 {
     SimpleTextureItem::finalizeGL();
-    d->bbox.destroy();
-    texture().destroy();
+    d->uploader.destroy();
+    d->placed.clear();
+    auto pool = OpenGLTexturePool::current();
+    pool->release(d->bbox);
+    pool->release(texture());
+    d->bbox = texture() = OpenGLTexture2D();
 }
 
 auto SubtitleRendererItem::text() const -> const RichTextDocument&
@@ -248,6 +292,7 @@ auto SubtitleRendererItem::style() const -> const OsdStyle&
 
 auto SubtitleRendererItem::unload() -> void
 {
+    d->cancelIndexing();
     d->selection.clear();
     qDeleteAll(d->loaded);
     d->loaded.clear();
@@ -261,8 +306,8 @@ auto SubtitleRendererItem::updateVertex(Vertex *vertex) -> void
 {
     const auto dpr = devicePixelRatio();
     const QRectF r(d->drawer. pos(d->imageSize/dpr, rect()), d->imageSize/dpr);
-    OGL::CoordAttr::fillTriangleStrip(vertex, &Vertex::position,
-                                      r.topLeft(), r.bottomRight());
+    Vertex::fillAsTriangleStrip(vertex, r.topLeft(), r.bottomRight(),
+                                {0, 0}, texture().correction());
 }
 
 auto SubtitleRendererItem::createData() const -> ShaderData*
@@ -282,6 +327,7 @@ auto SubtitleRendererItem::updateData(ShaderData *sd) -> void
 
 auto SubtitleRendererItem::updateTexture(OpenGLTexture2D *texture) -> void
 {
+    const auto prevSize = d->imageSize;
     d->imageSize = {0, 0};
     const int spacing = d->drawer.style().font.height()
             * d->drawer.scale(geometry())
@@ -292,32 +338,76 @@ auto SubtitleRendererItem::updateTexture(OpenGLTexture2D *texture) -> void
         d->imageSize.rheight() += image.height() + spacing;
     });
     d->imageSize.rheight() -= spacing;
-    if (!d->imageSize.isEmpty()) {
-        const auto len = d->imageSize.width()*d->imageSize.height();
-        _Expand(d->zeros, len);
-        OpenGLTextureBinder<OGL::Target2D> binder;
-        binder.bind(texture);
-        texture->initialize(d->imageSize, d->zeros.data());
-        binder.bind(&d->bbox);
-        d->bbox.initialize(d->imageSize, d->zeros.data());
-        int y = 0;
-        d->selection.forImages([&] (const SubCompImage &image) {
-            const int x = (texture->width() - image.width())*0.5;
-            if (!image.isNull()) {
-                binder.bind(texture);
-                texture->upload(x, y, image.width(), image.height(), image.bits());
-                binder.bind(&d->bbox);
-                for (auto &bbox : image.boundingBoxes()) {
-                    const auto rect = bbox.toRect().translated(x, y);
-                    if (_Expand(d->bboxData, rect.width()*rect.height()))
-                        d->bboxData.fill(_Max<quint32>());
-                    d->bbox.upload(rect, d->bboxData.data());
-                }
-            }
-            y += image.height() + spacing;
-        });
+    if (d->imageSize.isEmpty()) {
+        d->placed.clear();
+        return;
+    }
+    // storage is reused while size stays in same bucket of pool
+    auto pool = OpenGLTexturePool::current();
+    const OpenGLTextureTransferInfo info;
+    const bool renewed = pool->renew(*texture, d->imageSize, info)
+                       | pool->renew(d->bbox, d->imageSize, info);
+    QVector<Data::Placed> placed;
+    int y = 0;
+    d->selection.forImages([&] (const SubCompImage &image) {
+        const int x = (d->imageSize.width() - image.width())*0.5;
+        const QRect rect(x, y, image.width(), image.height());
+        placed.push_back({ image, rect, image.boundingBoxes() });
+        y += image.height() + spacing;
+    });
+    auto isSameLayout = [&] () {
+        if (renewed || prevSize != d->imageSize
+                || placed.size() != d->placed.size())
+            return false;
+        for (int i = 0; i < placed.size(); ++i) {
+            if (placed[i].rect != d->placed[i].rect
+                    || placed[i].bboxes != d->placed[i].bboxes)
+                return false;
+        }
+        return true;
+    };
+    if (isSameLayout()) {
+        // only rows which differ from previous upload
+        for (int i = 0; i < placed.size(); ++i) {
+            const auto &image = placed[i].image, &old = d->placed[i].image;
+            if (image.cacheKey() == old.cacheKey() || image.isNull())
+                continue;
+            const int h = image.height(), len = image.width() * 4;
+            auto same = [&] (int line) {
+                return !old.isNull() && old.format() == image.format()
+                    && !memcmp(old.constScanLine(line),
+                               image.constScanLine(line), len);
+            };
+            int first = 0, last = h - 1;
+            while (first < h && same(first))
+                ++first;
+            if (first >= h)
+                continue;
+            while (last > first && same(last))
+                --last;
+            const auto &rect = placed[i].rect;
+            d->uploader.add(*texture, { rect.x(), rect.y() + first,
+                                        rect.width(), last - first + 1 },
+                            image.constScanLine(first), image.bytesPerLine());
+        }
+    } else {
+        // clear one more texel to keep stale content from filtering
+        const auto clear = (d->imageSize + QSize(1, 1)).boundedTo(texture->size());
+        d->uploader.fill(*texture, { {0, 0}, clear }, 0);
+        d->uploader.fill(d->bbox, { {0, 0}, clear }, 0);
+        for (auto &p : placed) {
+            if (p.image.isNull())
+                continue;
+            d->uploader.add(*texture, p.rect, p.image.constBits(),
+                            p.image.bytesPerLine());
+            for (auto &bbox : p.bboxes)
+                d->uploader.fill(d->bbox, bbox.toRect().translated(p.rect.topLeft()),
+                                 _Max<quint32>());
+        }
         reserve(UpdateGeometry, false);
     }
+    d->uploader.commit();
+    d->placed = placed;
 }
 
 auto SubtitleRendererItem::afterUpdate() -> void
@@ -374,6 +464,11 @@ auto SubtitleRendererItem::setFPS(double fps) -> void
     d->selection.setFPS(fps);
 }
 
+auto SubtitleRendererItem::setSpeed(double speed) -> void
+{
+    d->selection.setSpeed(speed);
+}
+
 auto SubtitleRendererItem::fps() const -> double
 {
     return d->fps();
@@ -413,8 +508,10 @@ auto SubtitleRendererItem::load(const Subtitle &subtitle, bool select) -> bool
     if (subtitle.isEmpty())
         return false;
     const int idx = d->loaded.size();
-    for (int i=0; i<subtitle.size(); ++i)
+    for (int i=0; i<subtitle.size(); ++i) {
         d->loaded.append(new SubComp(subtitle[i]));
+        d->index(d->loaded.last());
+    }
     if (select) {
         d->selecting = true;
         for (int i=d->loaded.size()-1; i>=idx; --i) {
@@ -505,12 +602,20 @@ auto SubtitleRendererItem::next() const -> int
 auto SubtitleRendererItem::setComponents(const QVector<SubComp> &components) -> void
 {
     unload();
-    d->loaded.reserve(components.size());
-    for (const auto &comp : components)
+    addComponents(components);
+}
+
+auto SubtitleRendererItem::addComponents(const QVector<SubComp> &components) -> void
+{
+    const int from = d->loaded.size();
+    d->loaded.reserve(from + components.size());
+    for (const auto &comp : components) {
         d->loaded.push_back(new SubComp(comp));
-    for (const auto &comp : d->loaded) {
-        if (comp->selection())
-            d->selection.prepend(comp);
+        d->index(d->loaded.last());
+    }
+    for (int i = from; i < d->loaded.size(); ++i) {
+        if (d->loaded[i]->selection())
+            d->selection.prepend(d->loaded[i]);
     }
     d->sort();
     d->applySelection();
@@ -527,5 +632,41 @@ auto SubtitleRendererItem::customEvent(QEvent *event) -> void
         if (d->selection.update(_GetData<SubCompImage>(event)))
             d->textChanged = true;
         reserve(UpdateMaterial);
+    } else if (event->type() == SubCompSelection::CursorBuilt) {
+        d->selection.swapCursor(event);
+    } else if (event->type() == IndexBuilt) {
+        IndexFlag canceled; const SubComp *comp = nullptr; IndexPtr index;
+        _TakeData(event, canceled, comp, index);
+        if (!*canceled) {
+            d->indexes[comp] = index;
+            emit searchIndexChanged();
+        }
+    }
+}
+
+QVariantList SubtitleRendererItem::search(const QString &text, int limit) const
+{
+    struct Match { int time, key; const SubComp *comp; };
+    QVector<Match> matches;
+    for (auto comp : d->loaded) {
+        const auto index = d->indexes.value(comp);
+        if (!index)
+            continue;
+        for (int key : index->search(text, limit))
+            matches.push_back({ comp->toTime(key, d->fps()) + d->delay, key, comp });
     }
+    std::stable_sort(matches.begin(), matches.end(),
+                     [] (const Match &lhs, const Match &rhs)
+                     { return lhs.time < rhs.time; });
+    QVariantList list;
+    for (int i = 0; i < matches.size() && i < limit; ++i) {
+        const auto &match = matches[i];
+        const auto it = match.comp->map().find(match.key);
+        QVariantMap map;
+        map[u"time"_q] = match.time;
+        map[u"text"_q] = match.comp->text(it).trimmed();
+        map[u"name"_q] = match.comp->name();
+        list.push_back(map);
+    }
+    return list;
 }
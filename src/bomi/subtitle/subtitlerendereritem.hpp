@@ -24,6 +24,8 @@ public:
     auto models() const -> QVector<SubCompModel*>;
     auto components() const -> QVector<const SubComp *>;
     auto setComponents(const QVector<SubComp> &components) -> void;
+    // appends to loaded components and selects ones marked as selected
+    auto addComponents(const QVector<SubComp> &components) -> void;
     auto componentsCount() const -> int;
     auto setPriority(const QStringList &priority) -> void;
     auto setPos(double pos) -> void;
@@ -42,8 +44,14 @@ public:
     auto render(int ms) -> void;
     auto setTopAligned(bool top) -> void;
     auto setFPS(double fps) -> void;
+    auto setSpeed(double speed) -> void;
+    // captions of loaded components which contain all words of text as
+    // {time, text, name} in order of time. time includes delay so that it
+    // can be passed to PlayEngine::seek() as is.
+    Q_INVOKABLE QVariantList search(const QString &text, int limit = 100) const;
 signals:
     void modelsChanged(const QVector<SubCompModel*> &models);
+    void searchIndexChanged();
 private:
     auto initializeGL() -> void;
     auto finalizeGL() -> void;
@@ -1,172 +1,253 @@
 #include "subtitlerenderingthread.hpp"
+#include "subtitlerenderpool.hpp"
 #include "misc/dataevent.hpp"
+#include "misc/tracerecorder.hpp"
 
-template<>
-inline bool qMapLessThanKey(const SubCompItMapIt &lhs,
-                            const SubCompItMapIt &rhs) {
-    return lhs.key() < rhs.key();
-}
+static constexpr int NewOption = SubCompSelection::NewDrawer
+                                | SubCompSelection::NewArea;
+static constexpr int ForceUpdate = SubCompSelection::Rerender
+                                   | SubCompSelection::Rebuild | NewOption;
+// prerender captions starting within this time (scaled by playback speed)
+static constexpr int LookaheadTime = 4000;
+static constexpr int MinLookahead = 2, MaxLookahead = 8;
+// rendered images kept per component including recently shown ones
+static constexpr qint64 CacheBudget = 24*1024*1024;
 
-struct SubCompSelection::Thread::Data {
+struct SubCompSelection::Renderer::Data {
     Item *item = nullptr;
-    int time = 0;
     const SubComp *comp = nullptr;
-    SubCompItMap its;
-    SubCompItMapIt it = its.end();
-    QMap<SubCompItMapIt, SubCompImage> pool;
     QObject *receiver = nullptr;
-    bool quit = false;
-    double fps = 1.0, dpr = 1.0, mul = 1.0;
-    QMutex *mutex; QWaitCondition *wait;
+    SubCompCursor cursor;
+    SubCompItMapIt it = cursor.end();
+    double fps = 1.0, dpr = 1.0, speed = 1.0;
     QRectF rect; SubtitleDrawer drawer;
-    SubCompSelection *selection = nullptr;
+    int time = 0, flags = 0;
+    quint64 build = 0; // generation of cursor being built
+    SubtitleRenderPool *pool = SubtitleRenderPool::instance();
+    // shared with pool workers
+    struct Cached { SubCompImage image{nullptr}; quint64 used = 0; };
+    QMutex mutex;
+    QMap<int, Cached> cache; // valid only for current style
+    qint64 bytes = 0;
+    quint64 clock = 0, style = 0;
+    int current = _Min<int>(), last = _Min<int>(); // captions in use
 
-    SubComp::ConstIt iterator(int time) const { return comp->start(time, fps); }
-    auto newPicture(SubCompItMapIt it)
+    auto post(const SubCompImage &image) -> void
+        { _PostEvent(receiver, ImagePrepared, image); }
+    // the rest of functions should be called with mutex locked
+    auto evict() -> void
     {
-        auto pic = pool.insert(it, SubCompImage(comp, *it, item));
-        drawer.draw(*pic, rect, dpr);
-        return pic;
+        while (bytes > CacheBudget) {
+            auto victim = cache.end();
+            for (auto it = cache.begin(); it != cache.end(); ++it) {
+                if (current <= it.key() && it.key() <= last)
+                    continue;
+                if (victim == cache.end() || it->used < victim->used)
+                    victim = it;
+            }
+            if (victim == cache.end())
+                break;
+            bytes -= victim->image.byteCount();
+            cache.erase(victim);
+        }
     }
-    auto update()
+    auto store(int key, const SubCompImage &image) -> void
     {
-        if (quit)
-            return;
-        auto post = [this] (const SubCompImage &pic)
-            { _PostEvent(receiver, ImagePrepared, pic); };
-        if (it != its.end()) {
-            auto cache = pool.find(it);
-            if (cache == pool.end())
-                cache = newPicture(it);
-            post(*cache);
+        auto &cached = cache[key];
+        bytes += image.byteCount() - cached.image.byteCount();
+        cached.image = image;
+        cached.used = ++clock;
+        evict();
+    }
+    auto submit(SubCompItMapIt it, int priority) -> void
+    {
+        SubtitleRenderPool::Job job;
+        job.owner = this;
+        job.caption = it.key();
+        job.style = style;
+        job.priority = priority;
+        // copy everything the job needs since cursor may be rebuilt meanwhile
+        const auto key = it.key();
+        const auto capt = *it;
+        auto drawer = this->drawer;
+        const auto rect = this->rect;
+        const auto dpr = this->dpr, style = this->style;
+        job.run = [=] () mutable {
+            _TraceScope("SubCompSelection::draw");
+            SubCompImage image(comp, capt, item);
+            drawer.draw(image, rect, dpr);
+            QMutexLocker locker(&mutex);
+            if (style != this->style)
+                return;
+            store(key, image);
+            if (current == key)
+                post(image);
+        };
+        pool->submit(std::move(job));
+    }
+    auto request(SubCompItMapIt it, int priority) -> void
+    {
+        auto cached = cache.find(it.key());
+        if (cached != cache.end()) {
+            cached->used = ++clock;
+            if (!priority)
+                post(cached->image);
         } else
-            post(comp);
+            submit(it, priority);
     }
-
-    auto fillCache()
+    auto reset() -> void
+    {
+        ++style;
+        cache.clear();
+        bytes = 0;
+        pool->cancel(this);
+    }
+    auto draw(bool force) -> void
     {
-        if (it == its.end())
+        const auto iit = cursor.start(time);
+        if (!force && it == iit)
             return;
-        auto iit = pool.begin();
-        while (iit != pool.end() && iit.key().key() < it.key())
-            iit = pool.erase(iit);
-        Q_ASSERT(iit.key() == it);
-        auto key = it;
-        const int size = qMin(2, pool.size()+1);
-        for (int i=0; i<size; ++i) {
-            ++iit; ++key;
-            if (key == its.end())
+        QMutexLocker locker(&mutex);
+        // jumped: queued lookahead is useless but cache may still hit
+        if (it == cursor.end() || iit == cursor.end() || std::next(it) != iit)
+            pool->cancel(this);
+        it = iit;
+        if (it == cursor.end()) {
+            current = last = _Min<int>();
+            post(comp);
+            return;
+        }
+        current = last = it.key();
+        request(it, 0);
+        const int until = it.key() + LookaheadTime * qMax(speed, 0.1);
+        auto next = it;
+        for (int i = 1; i <= MaxLookahead && ++next != cursor.end(); ++i) {
+            if (i > MinLookahead && next.key() > until)
                 break;
-            if (iit == pool.end())
-                iit = newPicture(key);
+            last = next.key();
+            request(next, i);
         }
+        evict();
     }
-
-    auto draw(bool force)
+    // walking whole caption map is too slow for GUI thread.
+    // current cursor is kept until new one arrives via CursorBuilt
+    auto rebuild() -> void
     {
-        auto iit = --its.upperBound(time);
-        if (force || it != iit) {
-            if (it == its.end() || ++it != iit) {
-                pool.clear();
-                it = iit;
-                update();
-            } else {
-                update();
-                fillCache();
-            }
-        }
+        pool->cancel(&cursor);
+        SubtitleRenderPool::Job job;
+        job.owner = &cursor;
+        job.caption = _Min<int>();
+        job.style = ++build;
+        job.priority = -1;
+        const auto id = item->id;
+        const auto comp = this->comp;
+        const auto receiver = this->receiver;
+        const auto fps = this->fps;
+        const auto build = this->build;
+        job.run = [=] () {
+            _TraceScope("SubCompSelection::rebuild");
+            auto cursor = CursorPtr::create();
+            cursor->reset(*comp, fps);
+            _PostEvent(receiver, CursorBuilt, id, build, cursor);
+        };
+        pool->submit(std::move(job));
     }
-
-    auto rebuild()
+    auto apply() -> void
     {
-        pool.clear();
-        its.clear();
-        it = its.end();
-        for (auto iit = comp->begin(); iit != comp->end(); ++iit)
-            its.insert(comp->toTime(iit.key(), fps), iit);
+        if (time <= 0 || fps <= 0.0)
+            return;
+        const int flags = this->flags;
+        this->flags = 0;
+        if (flags & (Rebuild | NewOption)) {
+            mutex.lock();
+            reset();
+            mutex.unlock();
+        }
+        if (flags & Rebuild)
+            rebuild();
+        if (!cursor.isEmpty())
+            draw(flags & ForceUpdate);
     }
 };
 
-SubCompSelection::Thread::Thread(QMutex *mutex, QWaitCondition *wait,
-                                 Item *item, SubCompSelection *selection,
-                                 QObject *renderer)
-    : QThread()
-    , d(new Data)
+SubCompSelection::Renderer::Renderer(Item *item, QObject *receiver)
+    : d(new Data)
 {
     d->item = item;
     d->comp = item->comp;
-    d->receiver = renderer;
-    d->mutex = mutex;
-    d->wait = wait;
-    d->selection = selection;
+    d->receiver = receiver;
 }
 
-SubCompSelection::Thread::~Thread()
+SubCompSelection::Renderer::~Renderer()
 {
     finish();
     delete d;
 }
 
-auto SubCompSelection::Thread::setFPS(double fps) -> void
+auto SubCompSelection::Renderer::render(int time, int flags) -> void
 {
-    this->fps = fps; flags |= Rebuild;
+    d->time = time;
+    d->flags |= flags;
+    d->apply();
+}
+
+auto SubCompSelection::Renderer::setArea(const QRectF &rect, double dpr) -> void
+{
+    d->rect = rect; d->dpr = dpr;
+    render(d->time, NewArea);
+}
+
+auto SubCompSelection::Renderer::setDrawer(const SubtitleDrawer &drawer) -> void
+{
+    d->drawer = drawer;
+    render(d->time, NewDrawer);
+}
+
+auto SubCompSelection::Renderer::setFPS(double fps) -> void
+{
+    d->fps = fps;
     d->item->model->setFps(fps);
+    render(d->time, Rebuild);
 }
 
-auto SubCompSelection::Thread::finish() -> void
+auto SubCompSelection::Renderer::setSpeed(double speed) -> void
 {
-    d->quit = true;
-    d->wait->wakeAll();
-    if (!wait(5000))
-        terminate();
+    d->speed = speed;
 }
 
-auto SubCompSelection::Thread::run() -> void
+auto SubCompSelection::Renderer::setCursor(quint64 build,
+                                           const CursorPtr &cursor) -> void
 {
-    static constexpr int NewOption = NewDrawer | NewArea;
-    static constexpr int ForceUpdate = Rerender | Rebuild | NewOption;
-    int flags = 0;
-    while (!d->quit) {
-        QMutexLocker locker(d->mutex);
-        if (!(this->flags & ForceUpdate))
-            d->wait->wait(d->mutex);
-        if (d->quit)
-            break;
-        flags = this->flags;
-        this->flags = 0;
-        d->time = time;
-        d->fps = fps;
-        if (flags & NewOption) {
-            if (flags & NewDrawer)
-                d->drawer = drawer;
-            if (flags & NewArea) {
-                d->rect = rect;
-                d->dpr = dpr;
-            }
-        }
-        locker.unlock();
-        if (d->quit)
-            break;
-        if (flags & Rebuild)
-            d->rebuild();
-        if (flags & NewOption)
-            d->pool.clear();
-        if (d->quit)
-            break;
-        if (d->time > 0 && d->fps > 0.0 && !d->its.isEmpty())
-            d->draw(flags & ForceUpdate);
-    }
+    if (build != d->build)
+        return;
+    d->cursor = std::move(*cursor);
+    d->it = d->cursor.end();
+    // cached images are keyed by times of previous cursor
+    d->mutex.lock();
+    d->reset();
+    d->mutex.unlock();
+    render(d->time, Rerender);
+}
+
+auto SubCompSelection::Renderer::finish() -> void
+{
+    d->pool->cancel(&d->cursor, true);
+    d->pool->cancel(d, true);
+    d->mutex.lock();
+    d->current = d->last = _Min<int>();
+    d->cache.clear();
+    d->bytes = 0;
+    d->mutex.unlock();
 }
 
 /******************************************************************************/
 
 struct SubCompSelection::Data {
-    QMutex mutex;
-    QWaitCondition wait;
     QObject *renderer = nullptr;
     SubtitleDrawer drawer;
     QRectF rect;
-    double dpr = 1.0, fps = 30.0;
+    double dpr = 1.0, fps = 30.0, speed = 1.0;
+    quint64 ids = 0;
 };
 
 SubCompSelection::SubCompSelection(QObject *renderer)
@@ -205,15 +286,15 @@ auto SubCompSelection::drawer() const -> const SubtitleDrawer&
 auto SubCompSelection::setDrawer(const SubtitleDrawer &drawer) -> void
 {
     d->drawer = drawer;
-    forThreads([this] (Thread *t) { t->setDrawer(d->drawer); });
+    forRenderers([this] (Renderer *r) { r->setDrawer(d->drawer); });
 }
 
 auto SubCompSelection::clear() -> void
 {
     for (auto &item : items)
-        item.thread->finish();
-    wait.wakeAll();
+        item.renderer->finish();
     qApp->removePostedEvents(d->renderer, ImagePrepared);
+    qApp->removePostedEvents(d->renderer, CursorBuilt);
     for (auto &item : items)
         item.release();
     items.clear();
@@ -224,7 +305,7 @@ auto SubCompSelection::setArea(const QRectF &rect, double dpr) -> void
     if (d->rect == rect && d->dpr == dpr)
         return;
     d->rect = rect; d->dpr = dpr;
-    forThreads([this] (Thread *thread) { thread->setArea(d->rect, d->dpr); });
+    forRenderers([this] (Renderer *r) { r->setArea(d->rect, d->dpr); });
 }
 
 auto SubCompSelection::isEmpty() const -> bool
@@ -243,12 +324,13 @@ auto SubCompSelection::prepend(const SubComp *comp) -> bool
     items.push_front(Item());
     auto &item = items.front();
     item.comp = comp;
+    item.id = ++d->ids;
     item.model = new SubCompModel(comp, d->renderer);
-    item.thread = new Thread(&mutex, &wait, &item, this, d->renderer);
-    item.thread->setFPS(d->fps);
-    item.thread->setDrawer(d->drawer);
-    item.thread->setArea(d->rect, d->dpr);
-    item.thread->start();
+    item.renderer = new Renderer(&item, d->renderer);
+    item.renderer->setFPS(d->fps);
+    item.renderer->setSpeed(d->speed);
+    item.renderer->setDrawer(d->drawer);
+    item.renderer->setArea(d->rect, d->dpr);
     return true;
 }
 
@@ -260,7 +342,13 @@ auto SubCompSelection::fps() const -> double
 auto SubCompSelection::setFPS(double fps) -> void
 {
     if (_Change(d->fps, fps))
-        forThreads([this, fps] (Thread *t) { t->setFPS(fps); });
+        forRenderers([fps] (Renderer *r) { r->setFPS(fps); });
+}
+
+auto SubCompSelection::setSpeed(double speed) -> void
+{
+    if (_Change(d->speed, speed))
+        forRenderers([speed] (Renderer *r) { r->setSpeed(speed); });
 }
 
 auto SubCompSelection::update(const SubCompImage &image) -> bool
@@ -273,6 +361,18 @@ auto SubCompSelection::update(const SubCompImage &image) -> bool
     return true;
 }
 
+auto SubCompSelection::swapCursor(QEvent *event) -> void
+{
+    quint64 id = 0, build = 0; CursorPtr cursor;
+    _TakeData(event, id, build, cursor);
+    // item may have been removed while cursor was being built
+    const auto it = std::find_if(items.begin(), items.end(),
+                                 [id] (const Item &item)
+                                 { return item.id == id; });
+    if (it != items.end())
+        it->renderer->setCursor(build, cursor);
+}
+
 auto SubCompSelection::setMargin(double top, double bottom,
                                  double right, double left) -> void
 {
@@ -4,41 +4,41 @@
 #include "subtitledrawer.hpp"
 #include "subtitlemodel.hpp"
 
-using SubCompItMap = QMap<int, SubComp::ConstIt>;
-using SubCompItMapIt = SubCompItMap::const_iterator;
+using SubCompItMapIt = SubCompCursor::ConstIt;
 
 class SubCompSelection {
 public:
     static constexpr int ImagePrepared = QEvent::User+1;
+    static constexpr int CursorBuilt = ImagePrepared + 1;
     enum Flag {
         NewDrawer = 1, NewArea = 2, Rebuild = 4, Rerender = 8, Tick = 16
     };
 private:
     struct Item;
-    class Thread : public QThread {
+    using CursorPtr = QSharedPointer<SubCompCursor>;
+    // keeps caption map and cache of one component in GUI thread
+    // and hands drawing to SubtitleRenderPool
+    class Renderer {
     public:
-        Thread(QMutex *mutex, QWaitCondition *wait, Item *item,
-               SubCompSelection *selection, QObject *renderer);
-        ~Thread();
+        Renderer(Item *item, QObject *receiver);
+        ~Renderer();
         auto setFPS(double fps) -> void;
+        auto setSpeed(double speed) -> void;
         auto render(int time, int flags) -> void;
         auto setArea(const QRectF &rect, double dpr) -> void;
         auto setDrawer(const SubtitleDrawer &drawer) -> void;
+        auto setCursor(quint64 build, const CursorPtr &cursor) -> void;
         auto finish() -> void;
-        auto run() -> void;
     private:
-        QRectF rect;
-        double dpr = 1.0, fps = 1.0;
-        SubtitleDrawer drawer;
-        int time = 0, flags = 0;
         struct Data; Data *d;
     };
     struct Item {
         auto release() -> void;
-        Thread *thread  = nullptr;
+        Renderer *renderer = nullptr;
         const SubComp *comp = nullptr;
         SubCompImage image{nullptr};
         SubCompModel *model = nullptr;
+        quint64 id = 0; // unique unlike address which can be reused
     };
     using List = std::list<Item>;
 public:
@@ -61,8 +61,10 @@ public:
     auto prepend(const SubComp *comp) -> bool;
     auto contains(const SubComp *comp) const -> bool;
     auto update(const SubCompImage &pic) -> bool;
+    auto swapCursor(QEvent *event) -> void;
     auto fps() const -> double;
     auto setFPS(double fps) -> void;
+    auto setSpeed(double speed) -> void;
     auto setMargin(double top, double bottom,
                    double right, double left) -> void;
 private:
@@ -70,24 +72,13 @@ private:
     auto find(const SubComp *comp) -> List::iterator;
     auto find(const SubComp *comp) const -> List::const_iterator;
     template<class Func>
-    auto forThreads(Func func) -> void;
-    List items; mutable QMutex mutex;
-    mutable QWaitCondition wait;
+    auto forRenderers(Func func) -> void;
+    List items;
     struct Data;
     Data *d;
     QVector<SubCompImage> m_images;
 };
 
-inline auto SubCompSelection::Thread::render(int time, int flags) -> void
-{ this->time = time; this->flags |= flags; }
-
-inline auto SubCompSelection::Thread::setArea(const QRectF &rect,
-                                              double dpr) -> void
-{ this->rect = rect; this->dpr = dpr; flags |= NewArea; }
-
-inline auto SubCompSelection::Thread::setDrawer(const SubtitleDrawer &d) -> void
-{ this->drawer = d; flags |= NewDrawer; }
-
 template<class LessThan>
 inline auto SubCompSelection::sort(LessThan lt) -> void
 {
@@ -105,11 +96,11 @@ inline auto SubCompSelection::forImages(F f) const -> void
 { for (const auto &item : items) f(item.image); }
 
 inline auto SubCompSelection::render(int ms, int flags) -> void
-{ forThreads([this, ms, flags] (Thread *t) { t->render(ms, flags); }); }
+{ forRenderers([ms, flags] (Renderer *r) { r->render(ms, flags); }); }
 
 inline auto SubCompSelection::Item::release() -> void
 {
-    _Delete(thread);
+    _Delete(renderer);
     _Delete(model);
     if (comp)
         const_cast<SubComp*>(comp)->selection() = false;
@@ -138,12 +129,7 @@ inline auto SubCompSelection::find(const SubComp *comp) const
 }
 
 template<class Func>
-inline auto SubCompSelection::forThreads(Func func) -> void {
-    mutex.lock();
-    for (const auto &item : items)
-        func(item.thread);
-    mutex.unlock();
-    wait.wakeAll();
-}
+inline auto SubCompSelection::forRenderers(Func func) -> void
+{ for (const auto &item : items) func(item.renderer); }
 
 #endif // SUBTITLERENDERINGTHREAD_HPP
@@ -0,0 +1,152 @@
+#include "subtitlerenderpool.hpp"
+
+using Job = SubtitleRenderPool::Job;
+
+static auto isSame(const Job &lhs, const Job &rhs) -> bool
+{
+    return lhs.owner == rhs.owner && lhs.caption == rhs.caption
+            && lhs.style == rhs.style;
+}
+
+struct SubtitleRenderPool::Worker : public QThread {
+    Worker(SubtitleRenderPool::Data *d, int index): d(d), index(index) { }
+    auto run() -> void override;
+    auto take(Job &job) -> bool // called with mutex locked
+    {
+        if (jobs.empty())
+            return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+    SubtitleRenderPool::Data *d = nullptr;
+    int index = 0;
+    QMutex mutex;
+    std::deque<Job> jobs;
+    Job running;
+    bool busy = false;
+};
+
+struct SubtitleRenderPool::Data {
+    QVector<Worker*> workers;
+    QMutex sleep; QWaitCondition wakeup;
+    QWaitCondition done;
+    std::atomic<int> pending{0};
+    std::atomic<bool> quit{false};
+    auto steal(int from, Job &job) -> bool
+    {
+        for (int i = 1; i < workers.size(); ++i) {
+            auto w = workers[(from + i) % workers.size()];
+            QMutexLocker locker(&w->mutex);
+            if (w->take(job))
+                return true;
+        }
+        return false;
+    }
+};
+
+auto SubtitleRenderPool::Worker::run() -> void
+{
+    Job job;
+    while (!d->quit) {
+        mutex.lock();
+        bool found = take(job);
+        mutex.unlock();
+        if (!found)
+            found = d->steal(index, job);
+        if (!found) {
+            QMutexLocker locker(&d->sleep);
+            while (!d->quit && d->pending <= 0)
+                d->wakeup.wait(&d->sleep);
+            continue;
+        }
+        --d->pending;
+        mutex.lock();
+        running = job;
+        busy = true;
+        mutex.unlock();
+        job.run();
+        mutex.lock();
+        busy = false;
+        running = Job();
+        d->done.wakeAll();
+        mutex.unlock();
+    }
+}
+
+auto SubtitleRenderPool::instance() -> SubtitleRenderPool*
+{
+    static SubtitleRenderPool pool(qBound(1, QThread::idealThreadCount() - 1, 3));
+    return &pool;
+}
+
+SubtitleRenderPool::SubtitleRenderPool(int workers)
+    : d(new Data)
+{
+    for (int i = 0; i < workers; ++i) {
+        auto w = new Worker(d, i);
+        w->setObjectName(u"subtitle-render-"_q % QString::number(i));
+        d->workers.push_back(w);
+        w->start(QThread::LowPriority);
+    }
+}
+
+SubtitleRenderPool::~SubtitleRenderPool()
+{
+    d->sleep.lock();
+    d->quit = true;
+    d->wakeup.wakeAll();
+    d->sleep.unlock();
+    for (auto w : d->workers) {
+        w->wait();
+        delete w;
+    }
+    delete d;
+}
+
+auto SubtitleRenderPool::workers() const -> int
+{
+    return d->workers.size();
+}
+
+auto SubtitleRenderPool::submit(Job &&job) -> bool
+{
+    for (auto w : d->workers) {
+        QMutexLocker locker(&w->mutex);
+        if (w->busy && isSame(w->running, job))
+            return false;
+        for (auto &queued : w->jobs) {
+            if (isSame(queued, job))
+                return false;
+        }
+    }
+    // jobs of same owner go to same worker unless stolen
+    const auto hash = reinterpret_cast<quintptr>(job.owner) / sizeof(void*);
+    auto w = d->workers[hash % d->workers.size()];
+    w->mutex.lock();
+    auto it = std::upper_bound(w->jobs.begin(), w->jobs.end(), job.priority,
+                               [] (int priority, const Job &queued)
+                               { return priority < queued.priority; });
+    w->jobs.insert(it, std::move(job));
+    ++d->pending;
+    w->mutex.unlock();
+    d->sleep.lock();
+    d->wakeup.wakeOne();
+    d->sleep.unlock();
+    return true;
+}
+
+auto SubtitleRenderPool::cancel(const void *owner, bool wait) -> void
+{
+    for (auto w : d->workers) {
+        QMutexLocker locker(&w->mutex);
+        const auto size = w->jobs.size();
+        w->jobs.erase(std::remove_if(w->jobs.begin(), w->jobs.end(),
+                                     [owner] (const Job &job)
+                                     { return job.owner == owner; }),
+                      w->jobs.end());
+        d->pending -= size - w->jobs.size();
+        while (wait && w->busy && w->running.owner == owner)
+            d->done.wait(&w->mutex);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef SUBTITLERENDERPOOL_HPP
+#define SUBTITLERENDERPOOL_HPP
+
+#include <functional>
+
+// Fixed set of worker threads shared by all selected subtitle components.
+// Each worker owns a queue ordered by priority and steals from others
+// when its own one is empty. Jobs are identified by (owner, caption, style)
+// and duplicated submissions are ignored.
+class SubtitleRenderPool {
+public:
+    struct Job {
+        const void *owner = nullptr;
+        int caption = 0;
+        quint64 style = 0;
+        int priority = 0; // lower runs first
+        std::function<void(void)> run;
+    };
+    static auto instance() -> SubtitleRenderPool*;
+    ~SubtitleRenderPool();
+    // returns false if same job is queued or running already
+    auto submit(Job &&job) -> bool;
+    // drop queued jobs of owner and optionally wait for running ones
+    auto cancel(const void *owner, bool wait = false) -> void;
+    auto workers() const -> int;
+private:
+    SubtitleRenderPool(int workers);
+    struct Worker;
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLERENDERPOOL_HPP
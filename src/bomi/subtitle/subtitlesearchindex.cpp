@@ -0,0 +1,157 @@
+#include "subtitlesearchindex.hpp"
+#include "subtitle.hpp"
+
+// kana, han and hangul are written without spaces between words
+static auto isCjk(ushort c) -> bool
+{
+    return (0x3040 <= c && c <= 0x30ff)
+        || (0x3400 <= c && c <= 0x4dbf) || (0x4e00 <= c && c <= 0x9fff)
+        || (0xf900 <= c && c <= 0xfaff)
+        || (0x1100 <= c && c <= 0x11ff) || (0x3130 <= c && c <= 0x318f)
+        || (0xac00 <= c && c <= 0xd7af);
+}
+
+// splits text into words and runs of CJK characters
+template<class F>
+static auto forSegments(const QString &text, F func) -> void
+{
+    const auto s = text.constData();
+    const int size = text.size();
+    int i = 0;
+    while (i < size) {
+        const bool cjk = isCjk(s[i].unicode());
+        if (!cjk && !s[i].isLetterOrNumber()) {
+            ++i;
+            continue;
+        }
+        int j = i + 1;
+        for (; j < size; ++j) {
+            const bool other = isCjk(s[j].unicode());
+            if (cjk ? !other : (other || !s[j].isLetterOrNumber()))
+                break;
+        }
+        func(text.midRef(i, j - i), cjk);
+        i = j;
+    }
+}
+
+// a word as is, or bigrams of CJK run and its last character so that every
+// character begins some token
+template<class F>
+static auto forTokens(const QStringRef &segment, bool cjk, F func) -> void
+{
+    const auto s = segment.constData();
+    const int size = segment.size();
+    if (!cjk)
+        return func(segment.toString());
+    for (int i = 0; i + 1 < size; ++i)
+        func(QString(s + i, 2));
+    func(QString(s + size - 1, 1));
+}
+
+auto SubtitleSearchIndex::normalize(const QString &text) -> QString
+{
+    return text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+}
+
+auto SubtitleSearchIndex::build(const SubComp &comp,
+                                const std::function<bool(void)> &canceled) -> bool
+{
+    m_terms.clear();
+    m_keys.clear();
+    m_texts.clear();
+    QHash<QString, QVector<int>> terms;
+    for (auto it = comp.begin(); it != comp.end(); ++it) {
+        if (!it->hasWords())
+            continue;
+        if (canceled && !(m_keys.size() & 1023) && canceled())
+            return false;
+        const int idx = m_keys.size();
+        m_keys.push_back(it.key());
+        m_texts.push_back(normalize(comp.text(it)));
+        forSegments(m_texts.last(), [&] (const QStringRef &segment, bool cjk) {
+            forTokens(segment, cjk, [&] (const QString &token) {
+                auto &captions = terms[token];
+                if (captions.isEmpty() || captions.last() != idx)
+                    captions.push_back(idx);
+            });
+        });
+    }
+    m_terms.reserve(terms.size());
+    for (auto it = terms.begin(); it != terms.end(); ++it)
+        m_terms.push_back({ it.key(), it.value() });
+    std::sort(m_terms.begin(), m_terms.end(), [] (const Term &lhs, const Term &rhs)
+        { return lhs.token < rhs.token; });
+    return true;
+}
+
+auto SubtitleSearchIndex::find(const QString &token) const -> const Term*
+{
+    auto it = std::lower_bound(m_terms.begin(), m_terms.end(), token,
+                               [] (const Term &term, const QString &token)
+                               { return term.token < token; });
+    return it != m_terms.end() && it->token == token ? &*it : nullptr;
+}
+
+auto SubtitleSearchIndex::collect(const QString &prefix) const -> QVector<int>
+{
+    auto it = std::lower_bound(m_terms.begin(), m_terms.end(), prefix,
+                               [] (const Term &term, const QString &prefix)
+                               { return term.token < prefix; });
+    QVector<int> captions;
+    for (; it != m_terms.end() && it->token.startsWith(prefix); ++it)
+        captions += it->captions;
+    std::sort(captions.begin(), captions.end());
+    captions.erase(std::unique(captions.begin(), captions.end()), captions.end());
+    return captions;
+}
+
+auto SubtitleSearchIndex::search(const QString &query, int limit) const -> QVector<int>
+{
+    const auto text = normalize(query);
+    QVector<QStringRef> segments;
+    QVector<QString> tokens;
+    forSegments(text, [&] (const QStringRef &segment, bool cjk) {
+        segments.push_back(segment);
+        forTokens(segment, cjk, [&] (const QString &token)
+            { tokens.push_back(token); });
+    });
+    if (tokens.isEmpty())
+        return QVector<int>();
+    // a lone CJK character is indexed only at the end of a run. elsewhere
+    // it begins some bigram, so it matches as prefix like the last word.
+    auto isPrefix = [&] (int i) {
+        return i == tokens.size() - 1
+               || (tokens[i].size() == 1 && isCjk(tokens[i][0].unicode()));
+    };
+    QVector<int> matched;
+    for (int i = 0; i < tokens.size(); ++i) {
+        QVector<int> captions;
+        if (isPrefix(i))
+            captions = collect(tokens[i]);
+        else if (auto term = find(tokens[i]))
+            captions = term->captions;
+        if (i > 0) {
+            QVector<int> both;
+            std::set_intersection(matched.begin(), matched.end(),
+                                  captions.begin(), captions.end(),
+                                  std::back_inserter(both));
+            captions.swap(both);
+        }
+        matched.swap(captions);
+        if (matched.isEmpty())
+            return QVector<int>();
+    }
+    // bigrams tell nothing about their order
+    QVector<int> keys;
+    for (int idx : matched) {
+        const auto &capt = m_texts[idx];
+        auto contains = [&] (const QStringRef &s) { return capt.contains(s); };
+        if (!std::all_of(segments.begin(), segments.end(), contains))
+            continue;
+        keys.push_back(m_keys[idx]);
+        if (keys.size() >= limit)
+            break;
+    }
+    return keys;
+}
@@ -0,0 +1,28 @@
+#ifndef SUBTITLESEARCHINDEX_HPP
+#define SUBTITLESEARCHINDEX_HPP
+
+class SubComp;
+
+// inverted index of caption text of one component. words are normalized
+// by NFKC and case folding. runs of CJK characters are indexed as bigrams
+// because they are not separated by spaces.
+class SubtitleSearchIndex {
+public:
+    // returns false when build is canceled
+    auto build(const SubComp &comp, const std::function<bool(void)> &canceled
+               = std::function<bool(void)>()) -> bool;
+    // keys of captions which contain all words of query in ascending order.
+    // last word of query matches as prefix for incremental search.
+    auto search(const QString &query, int limit) const -> QVector<int>;
+    auto isEmpty() const -> bool { return m_keys.isEmpty(); }
+    static auto normalize(const QString &text) -> QString;
+private:
+    struct Term { QString token; QVector<int> captions; };
+    auto find(const QString &token) const -> const Term*;
+    auto collect(const QString &prefix) const -> QVector<int>;
+    QVector<Term> m_terms; // sorted by token
+    QVector<int> m_keys;
+    QVector<QString> m_texts; // normalized to verify order of CJK bigrams
+};
+
+#endif // SUBTITLESEARCHINDEX_HPP
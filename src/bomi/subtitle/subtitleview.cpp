@@ -1,6 +1,7 @@
 #include "subtitleview.hpp"
 #include "subtitlemodel.hpp"
 #include "subtitle.hpp"
+#include "subtitlerendereritem.hpp"
 
 auto set_window_title(QWidget *w, const QString &title) -> void;
 
@@ -39,6 +40,9 @@ struct SubtitleView::Data {
     QList<CompView*> comp;
     QSplitter *splitter;
     QCheckBox *timeVisible, *autoScroll;
+    QLineEdit *search;
+    QListWidget *results;
+    const SubtitleRendererItem *target = nullptr;
     bool needToUpdate = false;
 };
 
@@ -50,6 +54,10 @@ SubtitleView::SubtitleView(QWidget *parent)
     d->splitter = new QSplitter(Qt::Horizontal, area);
     d->timeVisible = new QCheckBox(tr("Show start/end time"), this);
     d->autoScroll = new QCheckBox(tr("Scroll to current time"), this);
+    d->search = new QLineEdit(this);
+    d->search->setPlaceholderText(tr("Search captions"));
+    d->results = new QListWidget(this);
+    d->results->setVisible(false);
 
     area->setWidget(d->splitter);
     area->setWidgetResizable(true);
@@ -57,6 +65,8 @@ SubtitleView::SubtitleView(QWidget *parent)
     d->timeVisible->setChecked(false);
 
     QVBoxLayout *vbox = new QVBoxLayout(this);
+    vbox->addWidget(d->search);
+    vbox->addWidget(d->results);
     vbox->addWidget(area);
     vbox->addWidget(d->timeVisible);
     vbox->addWidget(d->autoScroll);
@@ -68,6 +78,12 @@ SubtitleView::SubtitleView(QWidget *parent)
             this, &SubtitleView::setTimeVisible);
     connect(d->autoScroll, &QCheckBox::toggled,
             this, &SubtitleView::setAutoScrollEnabled);
+    connect(d->search, &QLineEdit::textChanged,
+            this, &SubtitleView::updateSearchResults);
+    connect(d->results, &QListWidget::itemActivated,
+            this, [this] (QListWidgetItem *item) {
+        emit seekRequested(item->data(Qt::UserRole).toInt());
+    });
 
     set_window_title(this, tr("Subtitle View"));
 }
@@ -110,6 +126,37 @@ auto SubtitleView::setModels(const QVector<SubCompModel*> &models) -> void
         d->needToUpdate = true;
 }
 
+auto SubtitleView::setSearchTarget(const SubtitleRendererItem *item) -> void
+{
+    if (d->target == item)
+        return;
+    if (d->target)
+        disconnect(d->target, nullptr, this, nullptr);
+    d->target = item;
+    if (d->target)
+        connect(d->target, &SubtitleRendererItem::searchIndexChanged,
+                this, &SubtitleView::updateSearchResults);
+    updateSearchResults();
+}
+
+auto SubtitleView::updateSearchResults() -> void
+{
+    d->results->clear();
+    const auto text = d->search->text();
+    d->results->setVisible(d->target && !text.trimmed().isEmpty());
+    if (!d->results->isVisible())
+        return;
+    for (auto &one : d->target->search(text)) {
+        const auto map = one.toMap();
+        const int time = map[u"time"_q].toInt();
+        auto item = new QListWidgetItem(d->results);
+        item->setText(_MSecToString(time) % ' '_q
+                      % map[u"text"_q].toString().replace('\n'_q, ' '_q));
+        item->setToolTip(map[u"name"_q].toString());
+        item->setData(Qt::UserRole, time);
+    }
+}
+
 auto SubtitleView::setTimeVisible(bool visible) -> void
 {
     for (int i=0; i<d->comp.size(); ++i)
@@ -2,7 +2,7 @@
 #define SUBTITLEVIEW_HPP
 
 class PlayEngine;                       class Subtitle;
-class SubCompModel;
+class SubCompModel;                     class SubtitleRendererItem;
 
 class SubtitleView : public QDialog {
     Q_OBJECT
@@ -10,7 +10,12 @@ public:
     SubtitleView(QWidget *parent = 0);
     ~SubtitleView();
     auto setModels(const QVector<SubCompModel*> &model) -> void;
+    // captions are searched in item if set
+    auto setSearchTarget(const SubtitleRendererItem *item) -> void;
+signals:
+    void seekRequested(int time);
 private:
+    auto updateSearchResults() -> void;
     auto setTimeVisible(bool visible) -> void;
     auto setAutoScrollEnabled(bool enabled) -> void;
     auto showEvent(QShowEvent *event) -> void;
@@ -0,0 +1,82 @@
+#include "decoderqualitycontroller.hpp"
+
+// ratio of decoding time to frame duration
+static constexpr double OverloadRatio = 0.9;
+static constexpr double RelaxRatio = 0.5;
+// successive overloaded updates required before degrading
+static constexpr int OverloadCount = 2;
+// minimum time between two level changes to let decoder settle
+static constexpr quint64 HoldTime = 1000000;
+// time of headroom required before restoring quality, doubled when
+// restoring turned out to be premature (flapping)
+static constexpr quint64 MinBackoff = 5000000;
+static constexpr quint64 MaxBackoff = 120000000;
+
+static const QVector<DecoderQualityController::Level> levels = {
+    { "default", "default", false },
+    { "nonref",  "default", false },
+    { "nonref",  "default", true  },
+    { "all",     "default", true  },
+    { "all",     "nonref",  true  }
+};
+
+auto DecoderQualityController::maximumLevel() -> int
+{
+    return levels.size() - 1;
+}
+
+auto DecoderQualityController::options(int level) -> const Level&
+{
+    return levels[qBound(0, level, maximumLevel())];
+}
+
+auto DecoderQualityController::reset() -> void
+{
+    m_level = m_overloaded = 0;
+    m_relaxed = false;
+    m_changed = m_relaxedSince = m_dropped = 0;
+    m_backoff = MinBackoff;
+    m_first = true;
+}
+
+auto DecoderQualityController::setLevel(int level, quint64 now) -> bool
+{
+    const bool up = level > m_level;
+    if (up && m_relaxed && now - m_changed < 2*m_backoff)
+        m_backoff = qMin(m_backoff*2, MaxBackoff);
+    m_relaxed = !up;
+    m_level = level;
+    m_changed = now;
+    m_overloaded = 0;
+    m_relaxedSince = 0;
+    return true;
+}
+
+auto DecoderQualityController::update(double decodeTime, double frameTime,
+                                      int queued, quint64 dropped) -> bool
+{
+    const bool dropping = !m_first && dropped > m_dropped;
+    m_dropped = dropped;
+    m_first = false;
+    if (decodeTime <= 0.0 || frameTime <= 0.0)
+        return false;
+    const auto now = _SystemTime();
+    const double load = decodeTime/frameTime;
+    // drops with full queue come from rendering, not decoding
+    if (load > OverloadRatio || (dropping && queued < 1))
+        ++m_overloaded;
+    else
+        m_overloaded = 0;
+    if (load < RelaxRatio && !dropping) {
+        if (!m_relaxedSince)
+            m_relaxedSince = now;
+    } else
+        m_relaxedSince = 0;
+    if (m_changed && now - m_changed < HoldTime)
+        return false;
+    if (m_overloaded >= OverloadCount && m_level < maximumLevel())
+        return setLevel(m_level + 1, now);
+    if (m_level > 0 && m_relaxedSince && now - m_relaxedSince >= m_backoff)
+        return setLevel(m_level - 1, now);
+    return false;
+}
@@ -0,0 +1,30 @@
+#ifndef DECODERQUALITYCONTROLLER_HPP
+#define DECODERQUALITYCONTROLLER_HPP
+
+// Feedback controller which trades decoding quality for speed when software
+// decoding cannot keep up with playback and gives it back when possible.
+class DecoderQualityController {
+public:
+    struct Level {
+        const char *skipLoopFilter, *skipFrame;
+        bool fast;
+    };
+    DecoderQualityController() { reset(); }
+    auto reset() -> void;
+    auto level() const -> int { return m_level; }
+    auto options() const -> const Level& { return options(m_level); }
+    // call periodically; returns true if level has been changed
+    auto update(double decodeTime, double frameTime,
+                int queued, quint64 dropped) -> bool;
+    static auto maximumLevel() -> int;
+    static auto options(int level) -> const Level&;
+private:
+    auto setLevel(int level, quint64 now) -> bool;
+    int m_level = 0, m_overloaded = 0;
+    bool m_relaxed = false;
+    quint64 m_changed = 0, m_relaxedSince = 0, m_backoff = 0;
+    quint64 m_dropped = 0;
+    bool m_first = true;
+};
+
+#endif // DECODERQUALITYCONTROLLER_HPP
@@ -5,6 +5,7 @@
 #include "deintoption.hpp"
 #include "player/mpv_helper.hpp"
 #include "opengl/opengloffscreencontext.hpp"
+#include "misc/tracerecorder.hpp"
 extern "C" {
 #include <video/filter/vf.h>
 #include <video/vdpau.h>
@@ -88,6 +89,17 @@ private:
 
 vf_info vf_info_noformat = create_vf_info();
 
+// recently output frames are kept up to this amount of memory
+static constexpr qint64 HistoryBudget = 192*1024*1024;
+
+static auto imageBytes(const mp_image *mpi) -> qint64
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < mpi->num_planes; ++i)
+        bytes += qAbs(mpi->stride[i]) * mpi->plane_h[i];
+    return bytes;
+}
+
 struct VideoFilter::Data {
     VideoFilter *p = nullptr;
     vf_instance *vf = nullptr;
@@ -103,6 +115,35 @@ struct VideoFilter::Data {
     double ptsSkipStart = MP_NOPTS_VALUE, ptsLastSkip = MP_NOPTS_VALUE;
     bool skip = false;
 
+    // contiguous frames output since last seek. hwaccel surfaces are not
+    // kept because decoder has only a few of them.
+    std::deque<MpImage> history;
+    qint64 historyBytes = 0;
+    bool backstep = false; // next seek reset replays history
+    int replay = -1; // index of history to output next
+    double ptsReplayed = MP_NOPTS_VALUE; // decoded ones till here are dropped
+
+    auto clearHistory() -> void
+    {
+        history.clear();
+        historyBytes = 0;
+        replay = -1;
+        ptsReplayed = MP_NOPTS_VALUE;
+    }
+    auto record(const MpImage &mpi) -> void
+    {
+        if (IMGFMT_IS_HWACCEL(mpi->imgfmt) || mpi->pts == MP_NOPTS_VALUE)
+            return;
+        if (!history.empty() && mpi->pts <= history.back()->pts)
+            clearHistory();
+        history.push_back(mpi);
+        historyBytes += imageBytes(mpi.data());
+        while (historyBytes > HistoryBudget && history.size() > 1) {
+            historyBytes -= imageBytes(history.front().data());
+            history.pop_front();
+        }
+    }
+
     auto updateDeint() -> void
     {
         DeintOption opt;
@@ -166,6 +207,9 @@ auto VideoFilter::open(vf_instance *vf) -> int
             d->hwacc = new VaApiTool(vf->hwdec->hwctx->vaapi_ctx);
     }
     mp_image_pool_clear(d->pool);
+    d->mutex.lock();
+    d->clearHistory();
+    d->mutex.unlock();
     priv->vf->stopSkipping();
     return true;
 }
@@ -186,6 +230,9 @@ auto VideoFilter::reconfig(vf_instance *vf,
     auto v = priv(vf); auto d = v->d;
     d->params = *in;
     *out = *in;
+    d->mutex.lock();
+    d->clearHistory();
+    d->mutex.unlock();
     if (_Change(d->hwacc, !!IMGFMT_IS_HWACCEL(in->imgfmt)))
         d->updateDeint();
     return 0;
@@ -213,6 +260,21 @@ auto VideoFilter::isSkipping() const -> bool
     return d->skip;
 }
 
+auto VideoFilter::prepareBackstep(int pts) -> bool
+{
+    d->mutex.lock();
+    d->backstep = false;
+    for (int i = 1; i < (int)d->history.size(); ++i) {
+        if (qAbs(d->history[i]->pts * 1000.0 - pts) <= 1.0) {
+            d->backstep = true;
+            break;
+        }
+    }
+    const bool ret = d->backstep;
+    d->mutex.unlock();
+    return ret;
+}
+
 template<class F>
 static auto avgLuma(const mp_image *mpi, F &&addLine) -> double
 {
@@ -269,6 +331,7 @@ auto VideoFilter::filterIn(vf_instance *vf, mp_image *_mpi) -> int
 {
     if (!_mpi)
         return 0;
+    _TraceScope("VideoFilter::filterIn");
     auto v = priv(vf); Data *d = v->d;
     MpImage mpi = MpImage::wrap(_mpi);
     if (d->skip) {
@@ -324,12 +387,36 @@ auto VideoFilter::filterIn(vf_instance *vf, mp_image *_mpi) -> int
 
 auto VideoFilter::filterOut(vf_instance *vf) -> int
 {
+    _TraceScope("VideoFilter::filterOut");
     auto v = priv(vf); auto d = v->d;
+    if (d->replay >= 0) {
+        // mpv drops ones before backstep target as it does for hr-seek
+        MpImage mpi;
+        d->mutex.lock();
+        if (d->replay < (int)d->history.size())
+            mpi = d->history[d->replay++];
+        else
+            d->replay = -1;
+        d->mutex.unlock();
+        if (!mpi.isNull()) {
+            d->ptsReplayed = mpi->pts;
+            vf_add_output_frame(vf, mpi.take());
+            return 0;
+        }
+    }
     auto mpi = std::move(d->deinterlacer.pop());
     if (mpi.isNull())
         return 0;
+    if (d->ptsReplayed != MP_NOPTS_VALUE) {
+        if (mpi->pts != MP_NOPTS_VALUE && mpi->pts <= d->ptsReplayed)
+            return 0;
+        d->ptsReplayed = MP_NOPTS_VALUE;
+    }
     if (_Change(d->inter_o, d->deinterlacer.pass() ? d->inter_i : false))
         emit v->outputInterlacedChanged();
+    d->mutex.lock();
+    d->record(mpi);
+    d->mutex.unlock();
     vf_add_output_frame(vf, mpi.take());
 
     return 0;
@@ -343,9 +430,23 @@ auto VideoFilter::control(vf_instance *vf, int request, void* data) -> int
         *(int*)data = d->deint;
         return true;
     case VFCTRL_SET_DEINTERLACE:
-        if (_Change(d->deint, (bool)*(int*)data))
+        if (_Change(d->deint, (bool)*(int*)data)) {
             d->updateDeint();
+            d->mutex.lock();
+            d->clearHistory();
+            d->mutex.unlock();
+        }
         return true;
+    case VFCTRL_SEEK_RESET:
+        d->mutex.lock();
+        if (d->backstep && !d->history.empty()) {
+            d->replay = 0;
+            d->ptsReplayed = MP_NOPTS_VALUE;
+        } else
+            d->clearHistory();
+        d->backstep = false;
+        d->mutex.unlock();
+        return CONTROL_UNKNOWN;
     default:
         return CONTROL_UNKNOWN;
     }
@@ -354,6 +455,9 @@ auto VideoFilter::control(vf_instance *vf, int request, void* data) -> int
 auto VideoFilter::uninit(vf_instance *vf) -> void {
     auto v = priv(vf); auto d = v->d;
     d->deinterlacer.clear();
+    d->mutex.lock();
+    d->clearHistory();
+    d->mutex.unlock();
 }
 
 auto query_video_format(quint32 format) -> int
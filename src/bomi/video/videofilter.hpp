@@ -20,6 +20,9 @@ public:
     auto skipToNextBlackFrame() -> void;
     auto stopSkipping() -> void;
     auto isSkipping() const -> bool;
+    // returns true if the frame before the one at pts(in msec) is kept so
+    // that following backstep will be served without decoding
+    auto prepareBackstep(int pts) -> bool;
 signals:
     void inputInterlacedChanged();
     void outputInterlacedChanged();
@@ -2,6 +2,7 @@
 #include "letterboxitem.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/openglframebufferobject.hpp"
+#include "opengl/opengltexturepool.hpp"
 #include "opengl/opengltexturebinder.hpp"
 #include "misc/dataevent.hpp"
 #include "misc/log.hpp"
@@ -22,8 +23,7 @@ struct VideoRenderer::Data {
     GeometryItem *overlay = nullptr;
     OpenGLTexture2D black;
     OpenGLFramebufferObject *fbo = nullptr;
-    QSize displaySize{0, 1}, fboSize, prevSize;
-    QTimer sizeChecker;
+    QSize displaySize{0, 1}, fboSize;
     RenderFrameFunc render = nullptr;
 
     static auto isSameRatio(double r1, double r2) -> bool
@@ -111,14 +111,6 @@ VideoRenderer::VideoRenderer(QQuickItem *parent)
     setAcceptHoverEvents(true);
     setAcceptedMouseButtons(Qt::AllButtons);
     setFlag(ItemAcceptsDrops, true);
-    connect(&d->sizeChecker, &QTimer::timeout, [this] () {
-        if (_Change(d->prevSize, d->fboSizeHint())) {
-            d->sizeChecker.stop();
-            d->updateFboSize(d->prevSize);
-        }
-    });
-    d->sizeChecker.setInterval(300);
-    d->sizeChecker.setSingleShot(true);
 }
 
 VideoRenderer::~VideoRenderer() {
@@ -161,7 +153,8 @@ auto VideoRenderer::finalizeGL() -> void
 {
     SimpleTextureItem::finalizeGL();
     d->black.destroy();
-    _Delete(d->fbo);
+    OpenGLTexturePool::current()->release(d->fbo);
+    d->fbo = nullptr;
 }
 
 auto VideoRenderer::customEvent(QEvent *event) -> void
@@ -281,7 +274,8 @@ auto VideoRenderer::updatePolish() -> void
     SimpleTextureItem::updatePolish();
     QRectF letter;
     if (_Change(d->vtx, d->frameRect(geometry(), d->offset, &letter))) {
-        d->sizeChecker.start();
+        // resizing is cheap as long as it stays in same bucket of pool
+        d->updateFboSize(d->fboSizeHint());
         reserve(UpdateGeometry, false);
     }
     if (d->letterbox->set(rect(), letter))
@@ -298,8 +292,10 @@ auto VideoRenderer::updateTexture(OpenGLTexture2D *texture) -> void
         _Trace("VideoRendererItem::updateTexture(): no queued frame");
     } else if (!d->fboSize.isEmpty()) {
         d->redraw = false;
-        if (!d->fbo || d->fbo->size() != d->fboSize)
-            _Renew(d->fbo, d->fboSize);
+        if (!d->fbo || d->fbo->viewport() != d->fboSize) {
+            d->fbo = OpenGLTexturePool::current()->renew(d->fbo, d->fboSize);
+            reserve(UpdateGeometry, false);
+        }
         auto w = window();
         if (w && d->render) {
             w->resetOpenGLState();
@@ -307,10 +303,11 @@ auto VideoRenderer::updateTexture(OpenGLTexture2D *texture) -> void
             w->resetOpenGLState();
         }
     }
-    *texture = !d->fboSize.isEmpty() && d->fbo ? d->fbo->texture() : d->black;
+    const bool fbo = !d->fboSize.isEmpty() && d->fbo;
+    *texture = fbo ? d->fbo->texture() : d->black;
 
     if (d->take) {
-        auto image = texture->toImage();
+        auto image = fbo ? d->fbo->toImage() : texture->toImage();
         QImage osd;
 //        if (!image.isNull() && d->data.osd())
 //            osd = d->data.osd()->toImage();
@@ -328,7 +325,8 @@ auto VideoRenderer::updateTexture(OpenGLTexture2D *texture) -> void
 
 auto VideoRenderer::updateVertex(Vertex *vertex) -> void
 {
-    double top = 0.0, left = 0.0, right = 1.0, bottom = 1.0;
+    const auto &c = texture().correction();
+    double top = 0.0, left = 0.0, right = c.x(), bottom = c.y();
     if (d->flip_v)
         std::swap(top, bottom);
     if (d->flip_h)
@@ -25,6 +25,23 @@
 #include "talloc.h"
 #include "misc/bstr.h"
 #include "common/common.h"
+#include "osdep/atomics.h"
+
+#if HAVE_STDATOMIC
+static _Atomic(mp_trace_fn) trace_hook;
+#else
+static struct { mp_trace_fn volatile v; } trace_hook;
+#endif
+
+void mp_set_trace_hook(mp_trace_fn hook)
+{
+    atomic_store(&trace_hook, hook);
+}
+
+mp_trace_fn mp_get_trace_hook(void)
+{
+    return atomic_load(&trace_hook);
+}
 
 #define appendf(ptr, ...) \
     do {(*(ptr)) = talloc_asprintf_append_buffer(*(ptr), __VA_ARGS__);} while(0)
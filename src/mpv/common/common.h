@@ -92,4 +92,14 @@ bool mp_append_escaped_string(void *talloc_ctx, struct bstr *dst,
 char *mp_strerror_buf(char *buf, size_t buf_size, int errnum);
 #define mp_strerror(e) mp_strerror_buf((char[80]){0}, 80, e)
 
+// Set by the client to record trace events of mpv threads. phase is 'B' for
+// begin and 'E' for end. name must be a string literal. The hook can be
+// changed from any thread while others are tracing.
+typedef void (*mp_trace_fn)(const char *name, char phase);
+void mp_set_trace_hook(mp_trace_fn hook);
+mp_trace_fn mp_get_trace_hook(void);
+#define MP_TRACE_EVENT(name, phase) do { \
+    mp_trace_fn hook_ = mp_get_trace_hook(); \
+    if (hook_) hook_(name, phase); } while (0)
+
 #endif /* MPLAYER_MPCOMMON_H */
@@ -31,6 +31,7 @@
 #include "config.h"
 #include "options/options.h"
 #include "talloc.h"
+#include "common/common.h"
 #include "common/msg.h"
 #include "common/global.h"
 #include "osdep/threads.h"
@@ -395,7 +396,9 @@ static bool read_packet(struct demux_internal *in)
     in->idle = false;
     pthread_mutex_unlock(&in->lock);
     struct demuxer *demux = in->d_thread;
+    MP_TRACE_EVENT("demux_fill", 'B');
     bool eof = !demux->desc->fill_buffer || demux->desc->fill_buffer(demux) <= 0;
+    MP_TRACE_EVENT("demux_fill", 'E');
     update_cache(in);
     pthread_mutex_lock(&in->lock);
 
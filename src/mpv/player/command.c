@@ -544,6 +544,17 @@ static int mp_property_drop_frame_cnt(void *ctx, struct m_property *prop,
     return m_property_int_ro(action, arg, mpctx->dropped_frames_total);
 }
 
+/// Average time spent by the video decoder per frame (seconds)
+static int mp_property_decode_frame_time(void *ctx, struct m_property *prop,
+                                         int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    if (!mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+
+    return m_property_double_ro(action, arg, mpctx->d_video->decode_time);
+}
+
 static int mp_property_vo_drop_frame_count(void *ctx, struct m_property *prop,
                                            int action, void *arg)
 {
@@ -3258,6 +3269,7 @@ static const struct m_property mp_properties[] = {
     {"total-avsync-change", mp_property_total_avsync_change},
     {"drop-frame-count", mp_property_drop_frame_cnt},
     {"vo-drop-frame-count", mp_property_vo_drop_frame_count},
+    {"decode-frame-time", mp_property_decode_frame_time},
     {"percent-pos", mp_property_percent_pos},
     {"time-start", mp_property_time_start},
     {"time-pos", mp_property_time_pos},
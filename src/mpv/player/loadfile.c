@@ -784,12 +784,12 @@ static void transfer_playlist(struct MPContext *mpctx, struct playlist *pl)
     }
 }
 
-static int process_open_hooks(struct MPContext *mpctx)
+static int process_hooks(struct MPContext *mpctx, char *type)
 {
 
-    mp_hook_run(mpctx, NULL, "on_load");
+    mp_hook_run(mpctx, NULL, type);
 
-    while (!mp_hook_test_completion(mpctx, "on_load")) {
+    while (!mp_hook_test_completion(mpctx, type)) {
         mp_idle(mpctx);
         if (mpctx->stop_play) {
             // Can't exit immediately, the script would interfere with the
@@ -999,7 +999,7 @@ static void play_current_file(struct MPContext *mpctx)
     assert(mpctx->d_sub[0] == NULL);
     assert(mpctx->d_sub[1] == NULL);
 
-    if (process_open_hooks(mpctx) < 0)
+    if (process_hooks(mpctx, "on_load") < 0)
         goto terminate_playback;
 
     int stream_flags = STREAM_READ;
@@ -1153,6 +1153,9 @@ goto_reopen_demuxer: ;
         goto terminate_playback;
     }
 
+    if (process_hooks(mpctx, "on_preloaded") < 0)
+        goto terminate_playback;
+
     reinit_video_chain(mpctx);
     reinit_audio_chain(mpctx);
     reinit_subs(mpctx, 0);
@@ -916,8 +916,12 @@ void run_playloop(struct MPContext *mpctx)
     handle_vo_events(mpctx);
     handle_heartbeat_cmd(mpctx);
 
+    MP_TRACE_EVENT("fill_audio_out_buffers", 'B');
     fill_audio_out_buffers(mpctx, endpts);
+    MP_TRACE_EVENT("fill_audio_out_buffers", 'E');
+    MP_TRACE_EVENT("write_video", 'B');
     write_video(mpctx, endpts);
+    MP_TRACE_EVENT("write_video", 'E');
 
     // We always make sure audio and video buffers are filled before actually
     // starting playback. This code handles starting them at the same time.
@@ -21,12 +21,14 @@
 // cache is being slow.
 #define CACHE_WAIT_TIME 0.5
 
-// The time the cache sleeps in idle mode. This controls how often the cache
-// retries reading from the stream after EOF has reached (in case the stream is
-// actually readable again, for example if data has been appended to a file).
-// Note that if this timeout is too low, the player will waste too much CPU
-// when player is paused.
+// The time the cache sleeps in idle mode after EOF has been reached. This
+// controls how often the cache retries reading from the stream (in case the
+// stream is actually readable again, for example if data has been appended to
+// a file). It is doubled on every unsuccessful retry up to the maximum, so that
+// a paused player does not keep waking up. If the cache is idle because the
+// buffer is full, it sleeps until the reader wakes it up.
 #define CACHE_IDLE_SLEEP_TIME 1.0
+#define CACHE_IDLE_SLEEP_TIME_MAX 30.0
 
 // Time in seconds the cache updates "cached" controls. Note that idle mode
 // will block the cache from doing this, and this timeout is honored only if
@@ -469,6 +471,7 @@ static void *cache_thread(void *arg)
     pthread_mutex_lock(&s->mutex);
     update_cached_controls(s);
     double last = mp_time_sec();
+    double idle_sleep = CACHE_IDLE_SLEEP_TIME;
     while (s->control != CACHE_CTRL_QUIT) {
         if (mp_time_sec() - last > CACHE_UPDATE_CONTROLS_TIME) {
             update_cached_controls(s);
@@ -477,14 +480,24 @@ static void *cache_thread(void *arg)
         if (s->control > 0) {
             cache_execute_control(s);
         } else {
+            MP_TRACE_EVENT("cache_fill", 'B');
             cache_fill(s);
+            MP_TRACE_EVENT("cache_fill", 'E');
         }
         if (s->control == CACHE_CTRL_PING) {
             pthread_cond_signal(&s->wakeup);
             s->control = CACHE_CTRL_NONE;
         }
-        if (s->idle && s->control == CACHE_CTRL_NONE)
-            mpthread_cond_timedwait_rel(&s->wakeup, &s->mutex, CACHE_IDLE_SLEEP_TIME);
+        if (s->idle && s->control == CACHE_CTRL_NONE) {
+            if (!s->eof) {
+                pthread_cond_wait(&s->wakeup, &s->mutex);
+            } else {
+                mpthread_cond_timedwait_rel(&s->wakeup, &s->mutex, idle_sleep);
+                idle_sleep = MPMIN(idle_sleep * 2, CACHE_IDLE_SLEEP_TIME_MAX);
+            }
+        } else {
+            idle_sleep = CACHE_IDLE_SLEEP_TIME;
+        }
     }
     pthread_cond_signal(&s->wakeup);
     pthread_mutex_unlock(&s->mutex);
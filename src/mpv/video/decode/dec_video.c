@@ -311,7 +311,13 @@ struct mp_image *video_decode(struct dec_video *d_video,
 
     MP_STATS(d_video, "start decode video");
 
+    int64_t decode_start = mp_time_us();
     struct mp_image *mpi = d_video->vd_driver->decode(d_video, packet, drop_frame);
+    if (mpi && !drop_frame) {
+        double t = (mp_time_us() - decode_start) / 1e6;
+        d_video->decode_time = d_video->decode_time > 0
+                             ? d_video->decode_time * 0.9 + t * 0.1 : t;
+    }
 
     MP_STATS(d_video, "end decode video");
 
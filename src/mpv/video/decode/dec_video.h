@@ -72,6 +72,9 @@ struct dec_video {
     // Final PTS of previously decoded image
     double decoded_pts;
 
+    // Moving average of wall time spent per decoded frame (seconds)
+    double decode_time;
+
     int bitrate;          // compressed bits/sec
     float fps;            // FPS from demuxer or from user override
     float initial_decoder_aspect;
@@ -31,6 +31,9 @@ typedef struct lavc_ctx {
     enum AVPixelFormat pix_fmt;
     int best_csp;
     enum AVDiscard skip_frame;
+    // Last seen values of options which can be changed during playback
+    enum AVDiscard skip_frame_opt, skip_loop_filter_opt;
+    int fast_opt;
     const char *software_fallback_decoder;
 
     // From VO
@@ -395,6 +395,9 @@ static void init_avctx(struct dec_video *vd, const char *decoder,
 
     // Do this after the above avopt handling in case it changes values
     ctx->skip_frame = avctx->skip_frame;
+    ctx->skip_frame_opt = lavc_param->skip_frame;
+    ctx->skip_loop_filter_opt = lavc_param->skip_loop_filter;
+    ctx->fast_opt = lavc_param->fast;
 
     avctx->codec_tag = sh->format;
     avctx->coded_width  = sh->video->disp_w;
@@ -601,6 +604,31 @@ static int get_buffer2_hwdec(AVCodecContext *avctx, AVFrame *pic, int flags)
     return 0;
 }
 
+// Pick up skip/fast options changed at runtime (e.g. by a client which
+// trades decoding quality for speed) without reinitializing the decoder.
+static void update_live_params(struct dec_video *vd)
+{
+    vd_ffmpeg_ctx *ctx = vd->priv;
+    AVCodecContext *avctx = ctx->avctx;
+    struct vd_lavc_params *lavc_param = ctx->opts->vd_lavc_params;
+
+    if (ctx->skip_frame_opt != lavc_param->skip_frame) {
+        ctx->skip_frame_opt = lavc_param->skip_frame;
+        ctx->skip_frame = lavc_param->skip_frame;
+    }
+    if (ctx->skip_loop_filter_opt != lavc_param->skip_loop_filter) {
+        ctx->skip_loop_filter_opt = lavc_param->skip_loop_filter;
+        avctx->skip_loop_filter = lavc_param->skip_loop_filter;
+    }
+    if (ctx->fast_opt != lavc_param->fast) {
+        ctx->fast_opt = lavc_param->fast;
+        if (lavc_param->fast)
+            avctx->flags2 |= CODEC_FLAG2_FAST;
+        else
+            avctx->flags2 &= ~CODEC_FLAG2_FAST;
+    }
+}
+
 static int decode(struct dec_video *vd, struct demux_packet *packet,
                   int flags, struct mp_image **out_image)
 {
@@ -611,6 +639,8 @@ static int decode(struct dec_video *vd, struct demux_packet *packet,
     struct vd_lavc_params *lavc_param = ctx->opts->vd_lavc_params;
     AVPacket pkt;
 
+    update_live_params(vd);
+
     if (flags) {
         // hr-seek framedrop vs. normal framedrop
         avctx->skip_frame = flags == 2 ? AVDISCARD_NONREF : lavc_param->framedrop;
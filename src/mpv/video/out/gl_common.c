@@ -99,6 +99,7 @@ static const struct feature features[] = {
     {MPGL_CAP_1D_TEX,           "1D textures"},
     {MPGL_CAP_3D_TEX,           "3D textures"},
     {MPGL_CAP_DEBUG,            "debugging extensions"},
+    {MPGL_CAP_PROGRAM_BINARY,   "program binaries"},
     {MPGL_CAP_SW,               "suspected software renderer"},
     {0},
 };
@@ -364,6 +365,17 @@ static const struct gl_functions gl_functions[] = {
             {0}
         },
     },
+    // Used to cache linked shader programs on disk.
+    {
+        .extension = "GL_ARB_get_program_binary",
+        .provides = MPGL_CAP_PROGRAM_BINARY,
+        .functions = (const struct gl_function[]) {
+            DEF_FN(GetProgramBinary),
+            DEF_FN(ProgramBinary),
+            DEF_FN(ProgramParameteri),
+            {0}
+        },
+    },
 };
 
 #undef FN_OFFS
@@ -76,6 +76,7 @@ enum {
     MPGL_CAP_1D_TEX             = (1 << 14),
     MPGL_CAP_3D_TEX             = (1 << 15),
     MPGL_CAP_DEBUG              = (1 << 16),
+    MPGL_CAP_PROGRAM_BINARY     = (1 << 17),    // GL_ARB_get_program_binary
     MPGL_CAP_SW                 = (1 << 30),    // indirect or sw renderer
 };
 
@@ -278,6 +279,11 @@ struct GL {
 
     void (GLAPIENTRY *DebugMessageCallback)(MP_GLDEBUGPROC callback,
                                             const void *userParam);
+
+    void (GLAPIENTRY *GetProgramBinary)(GLuint, GLsizei, GLsizei *, GLenum *,
+                                        void *);
+    void (GLAPIENTRY *ProgramBinary)(GLuint, GLenum, const void *, GLsizei);
+    void (GLAPIENTRY *ProgramParameteri)(GLuint, GLenum, GLint);
 };
 
 #endif /* MPLAYER_GL_COMMON_H */
@@ -23,14 +23,19 @@
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <assert.h>
+#include <utime.h>
 
 #include <libavutil/common.h>
 
 #include "gl_video.h"
 
 #include "misc/bstr.h"
+#include "options/path.h"
+#include "osdep/io.h"
 #include "gl_common.h"
 #include "gl_hwdec.h"
 #include "gl_osd.h"
@@ -417,6 +422,7 @@ const struct m_sub_options gl_video_conf = {
                    CONF_RANGE, .min = 0, .max = 0.5),
         OPT_REMOVED("approx-gamma", "this is always enabled now"),
         OPT_STRING("custom-shader", custom_shader, 0),
+        OPT_STRING("shader-cache-dir", shader_cache_dir, 0),
         OPT_REMOVED("cscale-down", "chroma is never downscaled"),
         OPT_REMOVED("scale-sep", "this is set automatically whenever sane"),
         OPT_REMOVED("indirect", "this is set automatically whenever sane"),
@@ -959,6 +965,114 @@ static void bind_attrib_locs(GL *gl, GLuint program)
     gl->BindAttribLocation(program, VERTEX_ATTRIB_TEXCOORD, "vertex_texcoord");
 }
 
+// Path of cached binary for the given program sources, or NULL if caching
+// is disabled or not supported. The driver is part of the key because
+// binaries are only valid for the exact implementation that created them.
+static char *program_cache_path(void *talloc_ctx, struct gl_video *p,
+                                const char *header, const char *vertex,
+                                const char *frag)
+{
+    GL *gl = p->gl;
+    const char *dir = p->opts.shader_cache_dir;
+    if (!dir || !dir[0] || !(gl->mpgl_caps & MPGL_CAP_PROGRAM_BINARY))
+        return NULL;
+    GLint formats = 0;
+    gl->GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+        return NULL;
+    const char *parts[] = {
+        (const char *)gl->GetString(GL_VENDOR),
+        (const char *)gl->GetString(GL_RENDERER),
+        (const char *)gl->GetString(GL_VERSION),
+        header, vertex, frag,
+    };
+    // FNV-1a, with terminating zero of each part included
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int n = 0; n < MP_ARRAY_SIZE(parts); n++) {
+        const char *s = parts[n] ? parts[n] : "";
+        do {
+            hash = (hash ^ (unsigned char)*s) * 0x100000001b3ULL;
+        } while (*s++);
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash);
+    return mp_path_join(talloc_ctx, bstr0(dir), bstr0(name));
+}
+
+static GLuint load_program_binary(struct gl_video *p, const char *path)
+{
+    GL *gl = p->gl;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    GLuint prog = 0;
+    void *data = NULL;
+    uint32_t format = 0;
+    long size = 0;
+    if (fseek(f, 0, SEEK_END) == 0)
+        size = ftell(f) - (long)sizeof(format);
+    if (size > 0 && fseek(f, 0, SEEK_SET) == 0 &&
+        fread(&format, sizeof(format), 1, f) == 1)
+    {
+        data = talloc_size(NULL, size);
+        if (fread(data, size, 1, f) == 1) {
+            prog = gl->CreateProgram();
+            gl->ProgramBinary(prog, format, data, size);
+            GLint status = 0;
+            gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+            if (!status) {
+                gl->DeleteProgram(prog);
+                prog = 0;
+            }
+        }
+    }
+    talloc_free(data);
+    fclose(f);
+    if (!prog) {
+        // e.g. driver update; drop the error and the stale file
+        while (gl->GetError() != GL_NO_ERROR) {}
+        MP_VERBOSE(p, "cached shader program '%s' rejected\n", path);
+        remove(path);
+    } else {
+        // the cache is pruned by mtime; mark this entry as recently used
+        utime(path, NULL);
+    }
+    return prog;
+}
+
+static void save_program_binary(struct gl_video *p, GLuint prog,
+                                const char *path)
+{
+    GL *gl = p->gl;
+    GLint status = 0, length = 0;
+    gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (status)
+        gl->GetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    void *data = talloc_size(NULL, length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    gl->GetProgramBinary(prog, length, &written, &format, data);
+    if (written > 0) {
+        mp_mkdirp(p->opts.shader_cache_dir);
+        // write to temporary file so that nobody sees a partial binary
+        char *tmp = talloc_asprintf(data, "%s.tmp", path);
+        FILE *f = fopen(tmp, "wb");
+        if (f) {
+            uint32_t format32 = format;
+            bool ok = fwrite(&format32, sizeof(format32), 1, f) == 1 &&
+                      fwrite(data, written, 1, f) == 1;
+            ok = fclose(f) == 0 && ok;
+            if (!ok || rename(tmp, path) != 0) {
+                MP_WARN(p, "could not write shader cache '%s'\n", path);
+                remove(tmp);
+            }
+        }
+    }
+    talloc_free(data);
+}
+
 #define PRELUDE_END "// -- prelude end\n"
 
 static GLuint create_program(struct gl_video *p, const char *name,
@@ -966,15 +1080,28 @@ static GLuint create_program(struct gl_video *p, const char *name,
                              const char *frag)
 {
     GL *gl = p->gl;
+    void *tmp = talloc_new(NULL);
+    char *cache = program_cache_path(tmp, p, header, vertex, frag);
+    GLuint prog = cache ? load_program_binary(p, cache) : 0;
+    if (prog) {
+        MP_VERBOSE(p, "loaded shader program '%s' from cache\n", name);
+        talloc_free(tmp);
+        return prog;
+    }
     MP_VERBOSE(p, "compiling shader program '%s', header:\n", name);
     const char *real_header = strstr(header, PRELUDE_END);
     real_header = real_header ? real_header + strlen(PRELUDE_END) : header;
     mp_log_source(p->log, MSGL_V, real_header);
-    GLuint prog = gl->CreateProgram();
+    prog = gl->CreateProgram();
     prog_create_shader(p, prog, GL_VERTEX_SHADER, header, vertex);
     prog_create_shader(p, prog, GL_FRAGMENT_SHADER, header, frag);
     bind_attrib_locs(gl, prog);
+    if (cache)
+        gl->ProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     link_shader(p, prog);
+    if (cache)
+        save_program_binary(p, prog, cache);
+    talloc_free(tmp);
     return prog;
 }
 
@@ -54,6 +54,7 @@ struct gl_video_opts {
     int use_rectangle;
     struct m_color background;
     char *custom_shader;
+    char *shader_cache_dir;
     int smoothmotion;
     float smoothmotion_threshold;
 };